@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Scene;
+
+/**
+ * @brief In-engine microbenchmarks for the animation sampling path.
+ *
+ */
+namespace AnimationBenchmark {
+
+/**
+ * @brief Timings of sampling every channel of one clip over its whole duration, repeated 'loops' times.
+ *
+ */
+struct ClipLookupResult {
+	std::string modelName;
+	std::string clipName;
+	std::size_t channelCount{};
+	std::size_t keyCount{};
+	std::size_t sampleCount{};
+	bool compressed{}; // Timed on the quantized key times of the compressed tracks, the channels are gone
+	double linearMs{}; // linear scan from the first keyframe (the original lookup)
+	double binaryMs{}; // binary search on every sample
+	double cursorMs{}; // cached keyframe cursor
+};
+
+/**
+ * @brief Timings of CPU skinning every vertex of one model's current pose, repeated 'loops' times.
+ *
+ */
+struct SkinningResult {
+	std::string modelName;
+	std::size_t vertexCount{};
+	std::size_t jointCount{};
+	std::size_t threadCount{}; // Workers plus the main thread, used by the parallel run
+	int loops{};
+	double scalarMs{};	 // glm matrix blend per vertex (the original bounding box loop)
+	double simdMs{};		 // AnimationKernels::skinPositions on one thread
+	double parallelMs{}; // The same kernel in chunks on the AnimationSystem workers
+
+	// Vertices per second per core
+	double scalarRate() const { return rate_(scalarMs, 1); }
+	double simdRate() const { return rate_(simdMs, 1); }
+	double parallelRate() const { return rate_(parallelMs, threadCount); }
+
+private:
+	double rate_(double ms, std::size_t cores) const { return ms > 0.0 && cores > 0 ? vertexCount * loops / (ms / 1000.0) / cores : 0.0; }
+};
+
+// Runs the keyframe lookup benchmark on every clip of every animated game object in the scene
+std::vector<ClipLookupResult> runKeyframeLookup(Scene const& scene, float sampleRate = 60.0f, int loops = 20);
+void printResults(std::vector<ClipLookupResult> const& results);
+
+// Runs the skinning benchmark once per skinned model in the scene, with the pose of the first object using it.
+// Main thread only, outside of an AnimationSystem dispatch
+std::vector<SkinningResult> runSkinning(Scene const& scene, int loops = 20);
+void printResults(std::vector<SkinningResult> const& results);
+
+} // namespace AnimationBenchmark
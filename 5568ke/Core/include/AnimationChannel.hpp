@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -23,11 +24,23 @@ class AnimationChannel {
 public:
 	void loadChannelData(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel);
 
-	glm::vec3 getScaling(float time) const;
-	glm::vec3 getTranslation(float time) const;
-	glm::quat getRotation(float time) const;
+	// 'cursor' caches the keyframe found by the previous call, so monotonic playback advances in O(1).
+	// Seeks and loop wraps fall back to a binary search. Any value is valid, start a new playback with 0.
+	glm::vec3 getScaling(float time, std::size_t& cursor) const;
+	glm::vec3 getTranslation(float time, std::size_t& cursor) const;
+	glm::quat getRotation(float time, std::size_t& cursor) const;
 	float getMaxTime() const;
 
+	// Index i of the keyframe pair with timings_[i] < time <= timings_[i + 1], time must lie strictly inside the channel
+	std::size_t findKeyframe(float time, std::size_t& cursor) const;
+
+	// Raw keyframe data, cubic spline channels store (in-tangent, value, out-tangent) per keyframe
+	InterpolationType getInterpolationType() const { return interpolationType_; }
+	std::vector<float> const& getTimings() const { return timings_; }
+	std::vector<glm::vec3> const& getScalings() const { return scalings_; }
+	std::vector<glm::vec3> const& getTranslations() const { return translations_; }
+	std::vector<glm::quat> const& getRotations() const { return rotations_; }
+
 	int targetNode{-1};
 	TargetPath targetPath = TargetPath::ROTATION;
 
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "AnimationTypes.hpp"
+#include "BakedClip.hpp"
+#include "CompiledClip.hpp"
+#include "CompressedClip.hpp"
+
 // Forward declarations
 namespace tinygltf {
 class Model;
@@ -13,22 +19,88 @@ struct Animation;
 struct AnimationChannel;
 } // namespace tinygltf
 class Node;
+struct Pose;
 class AnimationChannel;
+struct ClipSource;
+
+/**
+ * @brief Whether a clip's keyframe data is in memory. Clips created from a source descriptor start out evicted
+ * and are decoded by the ClipResidency manager the first time they are sampled.
+ */
+enum class ClipResidencyState { RESIDENT, DECODING, EVICTED };
 
 /**
  * @brief The animation clips in a model. A model can have many clips, each of which represents a piece of animation.
  *
  */
-class AnimationClip {
+class AnimationClip : public std::enable_shared_from_this<AnimationClip> {
 public:
 	AnimationClip(std::string const& name);
 
+	// A clip that only keeps a packed copy of the animation's accessors until it is first sampled. The decoded clip is
+	// compressed against 'nodes' or just compiled, as the loader would have done. nullptr if the animation has no valid channel
+	static std::shared_ptr<AnimationClip> createLazy(std::string const& name, tinygltf::Model const& model, tinygltf::Animation const& anim,
+																									 std::vector<std::shared_ptr<Node>> const& nodes, bool compress, float tolerance);
+
 	void addChannel(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel);
-	void setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time);
+	void compile(); // Rebuilds the SoA tracks sampled by setAnimationFrame, call once all channels are added
+
+	// Writes the local TRS of every animated node into 'pose', composing the matrices is up to the pose's owner (see AnimationInstance)
+	void setAnimationFrame(Pose& pose, float time) const;
+	void setAnimationFrame(Pose& pose, float time, AnimationCursor& cursor) const;
 	float getDuration() const;
 
+	// Optional fixed-rate pose tables, once baked setAnimationFrame samples them instead of the keyframes.
+	// A clip that is not resident is baked right after it is decoded, and again whenever it is decoded after an eviction
+	void bake(float sampleRate);
+	void clearBake();
+	bool isBaked() const { return baked_.isBaked(); }
+	BakeReport const& getBakeReport() const { return baked_.getReport(); }
+
+	// Replaces the full precision channels with quantized, key-reduced tracks, 'nodes' is the bind pose the clip animates
+	void compress(std::vector<std::shared_ptr<Node>> const& nodes, float tolerance);
+	bool isCompressed() const { return compressed_.isCompressed(); }
+	CompressionReport const& getCompressionReport() const { return compressed_.getReport(); }
+	CompressedClip const& getCompressed() const { return compressed_; }
+
+	// Keyframe sampling without the baked tables, from the compressed tracks if any, else the compiled ones
+	void evaluateKeyframes(Pose& pose, float time, std::size_t* cursors) const;
+	std::vector<int> getTargetNodes(TargetPath path) const;
+	std::size_t getChannelCount() const;
+	std::size_t getMemoryBytes() const; // Channels, compiled or compressed tracks and pose tables
+
+	// Residency, sampling a clip that is not resident requests it and leaves the pose untouched
+	ClipResidencyState getResidency() const { return residency_.load(std::memory_order_acquire); }
+	bool isResident() const { return getResidency() == ClipResidencyState::RESIDENT; }
+	bool canEvict() const { return source_ != nullptr; }
+	void requestResident() const;
+	std::shared_ptr<AnimationClip const> decodeNow() const; // This clip when resident, otherwise a decoded copy (blocking, for load-time tools)
+	float getLastUsed() const { return lastUsed_.load(std::memory_order_relaxed); } // ClipResidency clock
+	std::size_t getSourceBytes() const;
+
+	// Full precision channels, empty once the clip is compressed
+	std::vector<std::shared_ptr<AnimationChannel>> const& getChannels() const { return channels_; }
+
 	std::string clipName;
 
 private:
+	friend class ClipResidency;
+
+	void applyFrame_(Pose& pose, float time, std::size_t* cursors) const;
+
+	// Called by ClipResidency: decode runs on its loader thread, install and evict on the main thread between frames
+	std::shared_ptr<AnimationClip> decode_() const;
+	void install_(AnimationClip& decoded);
+	void evict_();
+
 	std::vector<std::shared_ptr<AnimationChannel>> channels_{};
+	CompiledClip compiled_{};
+	CompressedClip compressed_{};
+	BakedClip baked_{};
+
+	std::shared_ptr<ClipSource const> source_; // Only for lazily created clips
+	float duration_{};												 // Of the source, valid while evicted
+	mutable std::atomic<ClipResidencyState> residency_{ClipResidencyState::RESIDENT};
+	mutable std::atomic<float> lastUsed_{0.0f};
+	std::atomic<float> bakeRate_{0.0f}; // Requested bake rate, 0 when not baked
 };
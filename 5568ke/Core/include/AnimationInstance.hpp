@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AnimationTypes.hpp"
+#include "BoundingBox.hpp"
+#include "PosePool.hpp"
+#include "SkinnedVertexCache.hpp"
+
+class Model;
+
+/**
+ * @brief Playback state and pose of one animated object. The skeleton, inverse bind matrices and clips stay shared in the Model,
+ * so any number of objects spawned from one model can play different clips at different times.
+ */
+class AnimationInstance {
+public:
+	explicit AnimationInstance(std::shared_ptr<Model> model);
+
+	AnimationInstance(AnimationInstance const&) = delete;
+	AnimationInstance& operator=(AnimationInstance const&) = delete;
+
+	// Playback
+	void play(int clipIndex, float startTime = 0.0f);
+	void stop(); // Back to the bind pose
+	void pause() { playing_ = false; }
+	void resume() { playing_ = clipIndex_ >= 0; }
+	void advance(float dt); // Moves the time of a playing clip, looping, and re-poses
+
+	// Level of detail: re-poses only on every 'interval'th call. With 'interpolate' the clip is sampled one interval ahead
+	// and the joint palette is blended toward it on the calls in between, otherwise the pose holds and the skipped time
+	// is caught up by the next update
+	void advanceReduced(float dt, int interval, bool interpolate);
+
+	// Fades from the current clip into another over 'duration' seconds. Both clips keep playing into their own pooled poses
+	// and are blended into the output pose until the new one has fully taken over. Mid-fade, the new fade starts from the
+	// blended pose on screen, held still
+	void crossfade(int clipIndex, float duration, float startTime = 0.0f);
+	bool isCrossfading() const { return fadeDuration_ > 0.0f; }
+	float getCrossfadeWeight() const { return isCrossfading() ? fadeTime_ / fadeDuration_ : 1.0f; }
+
+	// Poses a single frame without touching the playback state (e.g. scrubbing from the UI)
+	void setFrame(int clipIndex, float time);
+	void resetToBindPose();
+
+	void setSpeed(float newSpeed) { speed_ = newSpeed > 0.1f ? newSpeed : 0.1f; }
+	float getSpeed() const { return speed_; }
+	bool isPlaying() const { return playing_; }
+	int getClipIndex() const { return clipIndex_; }
+	float getTime() const { return time_; }
+	float getClipDuration() const;
+
+	// Pose
+	Pose const& getPose() const { return pose_.get(); }
+	BoundingBox const& getLocalBBox() const { return localBBox_; }
+	Model const& getModel() const { return *model_; }
+	PoseUpdateStats const& getLastUpdate() const { return lastUpdate_; } // What the latest re-pose recomputed
+	std::uint64_t getPoseVersion() const { return poseVersion_; }				 // Changes whenever the joint matrices do
+
+	// Skinned vertex positions of the current pose, re-skinned on the CPU only if the pose changed since the last call.
+	// Main thread only, outside of an AnimationSystem dispatch
+	SkinnedVertexCache const& getSkinnedVertices();
+
+private:
+	bool validClip_(int clipIndex) const;
+	float wrapTime_(int clipIndex, float time) const;
+	void sample_(int clipIndex, float time);
+	void step_(float dt);
+	void sampleCrossfade_();
+	void composeMatrices_(bool clipPose = true); // 'clipPose' is false for the bind pose, which precomputed clip bounds may not hold
+	bool clipBounds_(BoundingBox& out) const;		 // Precomputed bounds of the clips shaping the pose, if the model has them
+	void blendPalette_(float weight);
+
+	std::shared_ptr<Model> model_;
+	PooledPose pose_;
+	BoundingBox localBBox_{};
+	PoseUpdateStats lastUpdate_{};
+	std::uint64_t poseVersion_{};
+	SkinnedVertexCache skinnedVertices_;
+
+	int clipIndex_{-1};
+	float time_{};
+	float speed_{1.0f};
+	bool playing_{false};
+	AnimationCursor cursor_; // Keyframe cursors of the clip being played
+
+	// Crossfade, the poses are acquired on the first fade and kept so later transitions do not allocate
+	PooledPose fromPose_;
+	PooledPose toPose_;
+	int fromClipIndex_{-1}; // -1 while fromPose_ holds a blend frozen by a crossfade started mid-fade
+	float fromTime_{};
+	AnimationCursor fromCursor_;
+	float fadeTime_{};
+	float fadeDuration_{}; // 0 when not fading
+
+	// Reduced update rate
+	int lodFrame_{};				 // Calls since the last re-pose, 0 when running at full rate
+	float lodSkippedTime_{}; // Time held back while the pose was frozen
+	bool paletteBlending_{false};
+	std::vector<glm::mat4> palettePrev_; // Joint palette shown at the last re-pose
+	std::vector<glm::mat4> paletteNext_; // Joint palette sampled one interval ahead
+};
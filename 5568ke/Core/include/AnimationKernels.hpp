@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AnimationTypes.hpp"
+
+struct Pose;
+struct Vertex;
+
+/**
+ * @brief Batched SIMD kernels shared by the compiled and compressed clip formats.
+ * A clip gathers one lane per track into the staging planes, runs a kernel over all lanes and scatters the results into a pose.
+ */
+namespace AnimationKernels {
+
+/**
+ * @brief Per-thread scratch lanes of one track group. Every plane holds 'stride' floats, one per track, padded to the batch width.
+ *
+ */
+struct Staging {
+	static constexpr int kInputPlanes = 16; // lerp: a[4], b[4] / hermite: coefficients[4][4]
+	static constexpr int kOutputPlane = 16; // out[4]
+	static constexpr int kFactorPlane = 20; // t
+	static constexpr int kPlaneCount = 21;
+
+	std::vector<float> data;
+	std::size_t stride{};
+
+	void reserve(std::size_t laneCount);
+	void padLanes(std::size_t laneCount); // Padding lanes evaluate to the identity quaternion so normalization stays finite
+	float* plane(int index) { return data.data() + index * stride; }
+	float const* plane(int index) const { return data.data() + index * stride; }
+};
+
+Staging& threadStaging();
+
+void lerp(Staging& s, int componentCount);										 // out = a + (b - a) * t
+void hermite(Staging& s, int componentCount);									 // out = ((a * t + b) * t + c) * t + d
+void normalizeQuat(Staging& s);																 // normalizes the four output planes
+void scatter(Staging const& s, TargetPath path, std::vector<int> const& targetNodes, Pose& pose);
+
+// out = from + (to - from) * weight over every node's local TRS, rotations take the short arc and are renormalized
+void blendPoses(Pose const& from, Pose const& to, float weight, Pose& out);
+
+// Linear blend skinning of vertices [begin, end) into out[begin, end). Weights are renormalized over the joints in range,
+// vertices without any keep their bind position. Ranges are independent, so one mesh can be split across threads
+void skinPositions(Vertex const* vertices, std::size_t begin, std::size_t end, glm::mat4 const* jointMatrices, std::size_t jointCount, glm::vec3* out);
+
+constexpr int kCursorProbeCount = 4; // Keys stepped forward from the cursor before falling back to a binary search
+
+// Index i of the keyframe pair with timings[i] < time <= timings[i + 1], time must lie strictly inside the key range.
+// 'cursor' caches the previous result, monotonic playback advances in O(1) and seeks fall back to a binary search.
+template <typename T> std::size_t findKeyframe(T const* timings, std::size_t count, float time, std::size_t& cursor)
+{
+	std::size_t const last = count - 1;
+
+	// Monotonic playback: the key is the cached one or one of the next few
+	if (cursor < last && timings[cursor] < time) {
+		for (int probe = 0; probe < kCursorProbeCount && cursor < last; ++probe, ++cursor) {
+			if (time <= timings[cursor + 1])
+				return cursor;
+		}
+	}
+
+	// Seek or loop wrap: binary search for the first key at or after 'time' and re-seat the cursor
+	std::size_t lo = 0, hi = count;
+	while (lo < hi) {
+		std::size_t mid = (lo + hi) / 2;
+		if (timings[mid] < time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	cursor = lo - 1;
+	return cursor;
+}
+
+} // namespace AnimationKernels
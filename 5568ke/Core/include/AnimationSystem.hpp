@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PosePool.hpp"
+
+/**
+ * @brief Update rate tier of one animated object for a frame.
+ *
+ */
+enum class AnimationLOD { FULL = 0, REDUCED, OFFSCREEN, COUNT };
+
+class AnimationInstance;
+class GameObject;
+class Scene;
+
+/**
+ * @brief Drives every AnimationInstance of the scene once per frame. Instances share nothing but their read-only Model,
+ * so each one is an independent job for a pool of worker threads, the main thread joins in while it waits.
+ */
+class AnimationSystem {
+public:
+	static AnimationSystem& getInstance()
+	{
+		static AnimationSystem instance;
+		return instance;
+	}
+
+	// Collects the playing instances of active objects and starts advancing them by dt. Playback must not be changed until sync()
+	void dispatch(Scene& scene, float dt);
+	// Waits for every job of the last dispatch, then updates the world boxes of the objects whose pose moved.
+	// Call once before anything reads poses or bounds (collisions, rendering)
+	void sync();
+
+	// Runs task(0) .. task(count - 1) on the workers and the calling thread and returns once all are done. Main thread only,
+	// a dispatched update is synced first
+	void parallelFor(std::size_t count, std::function<void(std::size_t)> const& task);
+
+	std::size_t getWorkerCount() const { return workers_.size(); }
+	std::size_t getJobCount() const { return jobs_.size(); }
+	PoseUpdateStats const& getStats() const { return stats_; } // Nodes and joints recomposed by the last update
+	double getLastUpdateMs() const { return lastUpdateMs_; }	 // Dispatch to sync, wall clock
+	std::size_t getTierCount(AnimationLOD tier) const { return tierCounts_[static_cast<std::size_t>(tier)]; } // Objects per tier in the last dispatch
+
+private:
+	AnimationSystem();
+	~AnimationSystem();
+
+	AnimationSystem(AnimationSystem const&) = delete;
+	AnimationSystem& operator=(AnimationSystem const&) = delete;
+
+	struct Job {
+		GameObject* gameObject{};
+		AnimationInstance* animation{};
+		AnimationLOD tier{AnimationLOD::FULL};
+	};
+
+	static AnimationLOD selectTier_(GameObject const& gameObject, Scene const& scene, GameObject const* controlled);
+
+	void workerLoop_();
+	void runJobs_(); // Claims and runs jobs until none are left
+
+	std::vector<std::thread> workers_;
+	std::vector<Job> jobs_; // Reused every frame
+	std::function<void(std::size_t)> const* task_{}; // Set while parallelFor runs, its jobs replace the animation jobs
+	std::size_t jobCount_{};													// Jobs of the current batch
+	float dt_{};
+	int lodReducedInterval_{1};
+	int lodOffscreenInterval_{1};
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	std::size_t generation_{}; // Bumped by each dispatch, workers sleep until it changes
+	std::size_t activeWorkers_{}; // Workers inside runJobs_
+	bool quit_{false};
+
+	std::atomic<std::size_t> nextJob_{0};
+	std::atomic<std::size_t> pendingJobs_{0};
+	bool dispatched_{false};
+
+	PoseUpdateStats stats_{};
+	std::array<std::size_t, static_cast<std::size_t>(AnimationLOD::COUNT)> tierCounts_{};
+	double lastUpdateMs_{};
+	double dispatchTime_{};
+};
@@ -1,4 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 enum class InterpolationType { STEP, LINEAR, CUBICSPLINE };
 enum class TargetPath { ROTATION, TRANSLATION, SCALE };
+
+/**
+ * @brief Keyframe cursors of one playing clip instance, one entry per channel of the clip.
+ * Kept by whoever drives the playback so that several instances can play the same clip independently.
+ */
+struct AnimationCursor {
+	std::vector<std::size_t> keys;
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "AnimationSystem.hpp"
 #include "CollisionSystem.hpp"
 #include "DialogSystem.hpp"
 #include "GlobalAnimationState.hpp"
@@ -27,6 +28,7 @@ public:
 	GlobalAnimationState& animStateRef = GlobalAnimationState::getInstance();
 	CollisionSystem& collisionSysRef = CollisionSystem::getInstance();
 	DialogSystem& dialogSysRef = DialogSystem::getInstance();
+	AnimationSystem& animationSysRef = AnimationSystem::getInstance();
 
 private:
 	// Initialization methods
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+struct Pose;
+class AnimationClip;
+
+/**
+ * @brief Size and accuracy of a baked clip. Errors are the worst deviation from the keyframed clip, measured between baked frames.
+ *
+ */
+struct BakeReport {
+	float sampleRate{};						// Hz, requested rate
+	std::size_t frameCount{};
+	std::size_t bytes{};					// Pose table memory
+	float maxRotationError{};			// radians
+	float maxTranslationError{};	// model units
+	float maxScaleError{};
+};
+
+/**
+ * @brief A clip resampled at a fixed rate into dense local TRS pose tables.
+ * Sampling reads two neighbouring frames and blends them, no keyframe search is involved.
+ */
+class BakedClip {
+public:
+	void bake(AnimationClip const& source, float sampleRate); // Samples the source's keyframe tracks
+	void clear();
+	bool isBaked() const { return frameCount_ > 0; }
+
+	void sample(Pose& pose, float time) const;
+
+	BakeReport const& getReport() const { return report_; }
+
+private:
+	void measureError_(AnimationClip const& source);
+
+	float frameRate_{}; // Actual frames per second, the frames evenly span [0, duration_]
+	float duration_{};
+	std::size_t frameCount_{};
+
+	// Animated nodes per path
+	std::vector<int> rotationNodes_;
+	std::vector<int> translationNodes_;
+	std::vector<int> scaleNodes_;
+
+	// Frame-major tables, [frame * trackCount + track]
+	std::vector<glm::quat> rotations_;
+	std::vector<glm::vec3> translations_;
+	std::vector<glm::vec3> scales_;
+
+	BakeReport report_{};
+};
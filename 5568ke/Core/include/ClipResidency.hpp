@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class AnimationClip;
+
+/**
+ * @brief Memory of the clips that can be evicted, updated once per frame.
+ *
+ */
+struct ClipResidencyStats {
+	std::size_t trackedClips{};	 // Lazily created clips still owned by a model
+	std::size_t residentClips{};
+	std::size_t decodingClips{};
+	std::size_t residentBytes{}; // Decoded data of the resident clips
+	std::size_t sourceBytes{};	 // Packed descriptors of all tracked clips
+	std::size_t decodes{};			 // Since startup
+	std::size_t evictions{};
+};
+
+/**
+ * @brief Decodes lazily created clips on a loader thread the first time they are sampled, and evicts the least recently
+ * used ones once the decoded data exceeds the animation memory budget (GlobalAnimationState). Decoded clips are installed
+ * and evicted in update(), which must run while nothing samples clips (see AnimationSystem::dispatch).
+ */
+class ClipResidency {
+public:
+	static ClipResidency& getInstance()
+	{
+		static ClipResidency instance;
+		return instance;
+	}
+
+	void track(std::shared_ptr<AnimationClip> const& clip);	// Main thread, registers a lazily created clip
+	void request(std::shared_ptr<AnimationClip> clip);				// Any thread, the clip must already be marked as decoding
+	void update(float dt);
+
+	float now() const { return clock_; } // Seconds of update() time, stamps a clip's last use
+	ClipResidencyStats const& getStats() const { return stats_; }
+
+private:
+	ClipResidency();
+	~ClipResidency();
+
+	ClipResidency(ClipResidency const&) = delete;
+	ClipResidency& operator=(ClipResidency const&) = delete;
+
+	void loaderLoop_();
+	void evict_();
+
+	std::thread loader_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<std::shared_ptr<AnimationClip>> queue_;
+	std::vector<std::pair<std::shared_ptr<AnimationClip>, std::shared_ptr<AnimationClip>>> finished_; // (clip, decoded data)
+	bool quit_{false};
+
+	std::vector<std::weak_ptr<AnimationClip>> tracked_; // Main thread only, every lazily created clip
+	float clock_{};
+	ClipResidencyStats stats_{};
+};
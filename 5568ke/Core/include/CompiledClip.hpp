@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AnimationTypes.hpp"
+
+struct Pose;
+class AnimationChannel;
+
+/**
+ * @brief An animation clip compiled into structure-of-arrays tracks.
+ * Channels are grouped by target path and evaluation kernel, so a whole clip is sampled in a few batched SIMD passes
+ * that write straight into a pose's TRS.
+ */
+class CompiledClip {
+public:
+	// Max angle (radians) between nlerp and slerp on any segment for a LINEAR rotation track to take the nlerp kernel
+	static constexpr float kNlerpTolerance = 1e-3f;
+
+	void compile(std::vector<std::shared_ptr<AnimationChannel>> const& channels);
+	void clear();
+	bool isCompiled() const { return compiled_; }
+
+	// 'cursors' holds one keyframe cursor per source channel (see AnimationCursor), nullptr samples statelessly
+	void evaluate(Pose& pose, float time, std::size_t* cursors) const;
+
+	std::size_t getTrackCount() const;
+	std::size_t getMemoryBytes() const;
+	std::size_t getChannelCount() const { return channelCount_; }
+	std::vector<int> getTargetNodes(TargetPath path) const; // Sorted and unique
+
+private:
+	enum class Kernel { STEP, LERP, NLERP, SLERP, HERMITE };
+
+	/**
+	 * @brief Tracks of the same path sampled by the same kernel. Keyframe values are stored as one plane per component,
+	 * cubic spline tracks store the per-segment Hermite polynomial coefficients instead.
+	 */
+	struct TrackGroup {
+		TargetPath path{TargetPath::ROTATION};
+		Kernel kernel{Kernel::LERP};
+		int componentCount{3};
+
+		std::vector<int> targetNodes;						 // per track
+		std::vector<std::uint32_t> channelIndices; // per track, index of the source channel (and its cursor)
+		std::vector<std::uint32_t> keyOffsets;		 // per track + 1, into 'times'
+		std::vector<float> times;
+
+		// STEP / LERP / NLERP / SLERP: values[c][key]
+		// HERMITE: coefficients[k][c][segment] of ((a * t + b) * t + c) * t + d, segment = key - track index
+		std::vector<float> values[4];
+		std::vector<float> coefficients[4][4];
+	};
+
+	TrackGroup& groupFor_(TargetPath path, Kernel kernel);
+	void addTrack_(AnimationChannel const& channel, std::uint32_t channelIndex);
+	void evaluateGroup_(TrackGroup const& group, Pose& pose, float time, std::size_t* cursors) const;
+
+	std::vector<TrackGroup> groups_;
+	std::size_t channelCount_{};
+	bool compiled_{false};
+};
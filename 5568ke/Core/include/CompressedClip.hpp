@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "AnimationTypes.hpp"
+
+class Node;
+struct Pose;
+class AnimationChannel;
+
+/**
+ * @brief Memory footprint of a clip before and after compression.
+ *
+ */
+struct CompressionReport {
+	float tolerance{}; // Max pose error at the chain ends, model units
+	std::size_t rawBytes{};
+	std::size_t compressedBytes{};
+	std::size_t rawKeys{};
+	std::size_t compressedKeys{};
+
+	float getRatio() const { return compressedBytes > 0 ? static_cast<float>(rawBytes) / compressedBytes : 0.0f; }
+};
+
+/**
+ * @brief An animation clip stored with quantized keys and decompressed on the fly while sampling.
+ * Rotations use smallest-three in 48 bits, translations and scales 16 bits per component over the track's range and key times
+ * 16 bits over the clip's duration. Keys that the remaining ones can interpolate within the joint's error budget are removed,
+ * cubic spline tracks are resampled to linear first.
+ */
+class CompressedClip {
+public:
+	static constexpr float kTargetRatio = 4.0f; // Memory reduction aimed for, reached or not depending on the content and tolerance
+
+	// 'nodes' is the bind pose hierarchy the clip animates, it spreads 'tolerance' over every chain of joints
+	void compress(std::vector<std::shared_ptr<AnimationChannel>> const& channels, std::vector<std::shared_ptr<Node>> const& nodes, float tolerance);
+	void clear();
+	bool isCompressed() const { return compressed_; }
+
+	// 'cursors' holds one keyframe cursor per source channel (see AnimationCursor), nullptr samples statelessly
+	void evaluate(Pose& pose, float time, std::size_t* cursors) const;
+
+	float getDuration() const { return duration_; }
+	std::size_t getChannelCount() const { return channelCount_; }
+	std::vector<int> getTargetNodes(TargetPath path) const; // Sorted and unique
+	CompressionReport const& getReport() const { return report_; }
+
+	// Key times of one track in quantized units (seconds * getTimeScale()), for the keyframe lookup benchmark
+	struct TrackTimes {
+		std::uint16_t const* times;
+		std::size_t count;
+	};
+	std::vector<TrackTimes> getTrackTimes() const;
+	float getTimeScale() const { return timeScale_; }
+
+	// Quantization helpers, exposed for the error checks of the key reduction
+	static void packQuat(glm::quat const& q, std::uint16_t* packed);
+	static glm::quat unpackQuat(std::uint16_t const* packed);
+
+private:
+	/**
+	 * @brief Tracks of the same path and interpolation. Keys are 3 uint16 per key for every path.
+	 *
+	 */
+	struct TrackGroup {
+		TargetPath path{TargetPath::ROTATION};
+		bool step{false};
+
+		std::vector<int> targetNodes;						 // per track
+		std::vector<std::uint32_t> channelIndices; // per track, index of the source channel (and its cursor)
+		std::vector<std::uint32_t> keyOffsets;		 // per track + 1, into 'times'
+		std::vector<std::uint16_t> times;					 // quantized over [0, duration]
+		std::vector<std::uint16_t> keys;					 // 3 per key
+		std::vector<glm::vec3> rangeMin;					 // per track, translations and scales only
+		std::vector<glm::vec3> rangeScale;				 // per track, range / 65535
+	};
+
+	TrackGroup& groupFor_(TargetPath path, bool step);
+	void evaluateGroup_(TrackGroup const& group, Pose& pose, float time, std::size_t* cursors) const;
+	std::size_t computeBytes_() const;
+
+	std::vector<TrackGroup> groups_;
+	float duration_{};
+	float timeScale_{}; // Quantized time units per second
+	std::size_t channelCount_{};
+	bool compressed_{false};
+	CompressionReport report_{};
+};
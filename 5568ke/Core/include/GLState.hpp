@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+
+#include "include_5568ke.hpp"
+
+/**
+ * @brief State changing GL calls of a frame, issued to the driver or skipped because the state was already set.
+ *
+ */
+struct GLStateCounters {
+	std::size_t issued{};
+	std::size_t skipped{};
+};
+
+/**
+ * @brief Shadow of the GL state the renderer changes per draw (program, VAO, textures per unit, depth, cull and raster
+ * state). Calls that would set what is already set are skipped, queries are answered from the shadow instead of
+ * glGet*, which can stall. Anything that changes the tracked state directly must call invalidate() afterwards.
+ */
+class GLState {
+public:
+	static GLState& getInstance()
+	{
+		static GLState instance;
+		return instance;
+	}
+
+	void beginFrame(); // Publishes the last frame's counters and invalidates, loading and ImGui touch GL between frames
+	void invalidate(); // Forget everything, the next call of each kind is issued
+
+	void useProgram(GLuint program);
+	void forgetProgram(GLuint program); // Before glDeleteProgram, a new program may reuse the name
+	void bindVertexArray(GLuint vao);
+	void bindTexture(unsigned int unit, GLenum target, GLuint texture); // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_BUFFER
+
+	void setEnabled(GLenum cap, bool enabled); // GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_PROGRAM_POINT_SIZE
+	bool isEnabled(GLenum cap);
+	void depthMask(bool enabled);
+	bool getDepthMask();
+	void depthFunc(GLenum func);
+	GLenum getDepthFunc();
+	void cullFace(GLenum face);
+	void polygonMode(GLenum mode); // For GL_FRONT_AND_BACK
+	void lineWidth(float width);
+
+	GLuint getProgram() const { return program_ > 0 ? static_cast<GLuint>(program_) : 0; }
+	GLStateCounters const& getLastFrameCounters() const { return lastFrame_; }
+
+private:
+	GLState() { invalidate(); }
+	GLState(GLState const&) = delete;
+	GLState& operator=(GLState const&) = delete;
+
+	static constexpr long long kUnknown = -1;
+	static constexpr unsigned int kTextureUnits = 16; // Units above this are passed through untracked
+	static constexpr int kTextureTargets = 3;
+	static constexpr int kCaps = 4;
+
+	// Shared by every setter, 'current' is replaced by 'value' when they differ
+	bool change_(long long& current, long long value);
+
+	long long program_;
+	long long vao_;
+	long long activeUnit_;
+	long long textures_[kTextureUnits][kTextureTargets];
+	long long caps_[kCaps];
+	long long depthMask_;
+	long long depthFunc_;
+	long long cullFace_;
+	long long polygonMode_;
+	float lineWidth_;
+
+	GLStateCounters frame_{};
+	GLStateCounters lastFrame_{};
+};
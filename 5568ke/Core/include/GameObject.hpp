@@ -13,6 +13,7 @@
 
 #include "BoundingBox.hpp"
 
+class AnimationInstance;
 class Model;
 
 /**
@@ -39,6 +40,11 @@ public:
 	std::shared_ptr<Model> getModel() const { return model_; }
 	bool hasModel() const { return model_ != nullptr; }
 
+	// Animation state of this object, null for models without clips
+	std::shared_ptr<AnimationInstance> const& getAnimation() const { return animation_; }
+	bool hasAnimation() const { return animation_ != nullptr; }
+	BoundingBox const& getLocalBBox() const; // Current pose's bounds in model space
+
 	void translate(glm::vec3 const& translation);
 	void rotate(glm::vec3 const& rotationDelta);
 	void scaleBy(glm::vec3 const& scaleFactor);
@@ -93,8 +99,10 @@ public:
 private:
 	// Private members that need controlled access
 	std::shared_ptr<Model> model_{nullptr};
+	std::shared_ptr<AnimationInstance> animation_{nullptr};
 	glm::mat4 transform_{1.0f};
 
 	// Internal helper methods
 	glm::mat4 calculateTransformMatrix_() const;
+	void createAnimation_();
 };
@@ -10,39 +10,43 @@ public:
 		return instance;
 	}
 
-	// Animation state
-	bool isAnimating{};
+	// Object driven by the UI and the character controls, its playback state lives in its AnimationInstance
 	std::string gameObjectName;
-	int clipIndex{1};
-	float currentTime{};
 	float camSpeed{3.0f};
 
+	// Clip transitions
+	float crossfadeDuration{0.25f}; // Seconds, 0 switches clips instantly
+
+	// Level of detail, see AnimationSystem
+	bool lodEnabled{true};
+	float lodReducedDistance{12.0f}; // Characters further from the camera re-pose every lodReducedInterval frames
+	int lodReducedInterval{3};
+	int lodOffscreenInterval{0}; // Characters outside the view re-pose every N frames, 0 pauses them
+
+	// Bounds, per-clip boxes are precomputed when a model is loaded so playing instances need no per-frame bounds update
+	bool precomputeClipBounds{false};
+	float clipBoundsSampleRate{15.0f}; // Hz
+	float clipBoundsPadding{0.05f};		 // Fraction of the box size, covers motion between samples
+
+	// Clip baking
+	float bakeSampleRate{30.0f}; // Hz
+	bool bakeIdleClips{true};		 // NPC idle loops are baked when the NPC is added
+
+	// Clip residency, clips are decoded on first use and the least recently used ones evicted above the budget
+	bool lazyClips{true};
+	int clipMemoryBudgetKB{2048};
+	float clipEvictSeconds{20.0f}; // Unused for at least this long before a clip may be evicted
+
+	// Clip compression, applied when a model is loaded
+	bool compressClips{true};
+	float compressionTolerance{0.0005f}; // Max pose error at the end of each joint chain, model units
+
 	// Character movement state
 	bool characterMoveMode{false};
 	bool wasMoving{false};
 	float followDistance{3.0f};
 	float followHeight{1.0f};
 
-	// Animation control methods
-	void play(int clip, float initialTime = 0.0f)
-	{
-		clipIndex = clip;
-		currentTime = initialTime;
-		isAnimating = true;
-	}
-
-	void stop()
-	{
-		isAnimating = false;
-		currentTime = 0.0f;
-	}
-
-	void pause() { isAnimating = false; }
-	void resume() { isAnimating = true; }
-	void setAnimateSpeed(float newSpeed) { animateSpeed_ = newSpeed > 0.1f ? newSpeed : 0.1f; }
-	float getAnimateSpeed() const { return animateSpeed_; }
-
 private:
 	GlobalAnimationState() = default;
-	float animateSpeed_{1.0f};
 };
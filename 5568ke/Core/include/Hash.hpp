@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief FNV-1a over raw bytes, chained through 'hash' so a key can be built field by field.
+ *
+ */
+namespace Hash {
+
+constexpr std::uint64_t kSeed = 14695981039346656037ull;
+
+inline std::uint64_t hashBytes(std::uint64_t hash, void const* data, std::size_t size)
+{
+	unsigned char const* bytes = static_cast<unsigned char const*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+template <typename T> std::uint64_t hashValue(std::uint64_t hash, T const& value) { return hashBytes(hash, &value, sizeof(T)); }
+
+} // namespace Hash
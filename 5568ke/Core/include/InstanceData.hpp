@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief Per-instance vertex attributes of the instancing permutation of model.vert, one record per instance of an
+ * instanced draw. Mesh::bindInstances points attributes kFirstLocation onwards at an array of them.
+ */
+struct InstanceData {
+	static constexpr unsigned int kFirstLocation = 5; // aModel 5-8, aNormalMatrix 9-11, aPaletteOffset 12
+
+	glm::mat4 model{1.0f};
+	glm::vec3 normalMatrix[3]{glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)}; // Columns
+	std::int32_t paletteOffset{0};																																										// First joint of the instance in the joint palette, read by the skinning permutation
+};
+
+static_assert(sizeof(InstanceData) == 104, "InstanceData must stay tightly packed, it is read as vertex attributes");
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include "Primitive.hpp"
@@ -10,8 +11,8 @@ class Shader;
 class Mesh {
 public:
 	/**
-	 * @brief 'vertices' is the original vertex data of the Mesh.
-	 * The entire buffer is uploaded to GPU via 'vbo_', and drawing units (e.g., primitives)
+	 * @brief 'vertices' is the original vertex data of the Mesh, kept for bounds and CPU skinning.
+	 * setup() uploads it to 'vbo_' in a packed layout (see Mesh.cpp), and drawing units (e.g., primitives)
 	 * reference into this data pool using indices.
 	 *
 	 * Each Vertex includes:
@@ -25,7 +26,8 @@ public:
 
 	/**
 	 * @brief 'indices' define how to assemble triangles using vertices.
-	 * This is the index buffer (EBO) and will be used with glDrawElements.
+	 * This is the index buffer (EBO) and will be used with glDrawElements. setup() uploads each primitive's range
+	 * as 16-bit indices whenever the vertices it spans fit.
 	 *
 	 * For example, every group of 3 indices forms a triangle.
 	 */
@@ -43,10 +45,15 @@ public:
 
 	/**
 	 * @brief Initializes OpenGL buffers (VAO, VBO, EBO) and uploads vertex/index data.
-	 * Also configures vertex attribute pointers.
+	 * Also configures vertex attribute pointers. Vertices are packed to 20 bytes (position, octahedral normal, half-float UV),
+	 * plus 8 or 12 bytes of joint indices and unorm8 weights when the mesh is skinned.
 	 */
 	void setup();
 
+	bool isSkinned() const { return skinned_; }
+	std::size_t getVertexBytes() const { return vertexBytes_; } // Size of the uploaded vertex buffer
+	std::size_t getIndexBytes() const { return indexBytes_; }		// Size of the uploaded index buffer
+
 	/**
 	 * @brief Renders the mesh using the given shader.
 	 * Iterates through all primitives, binds their materials, and issues draw calls.
@@ -55,9 +62,34 @@ public:
 	 */
 	void draw(Shader const& shader) const;
 
+	/**
+	 * @brief Binds the mesh's buffers for drawPrimitive().
+	 */
+	void bind() const;
+
+	/**
+	 * @brief Points the per-instance attributes (see InstanceData) of the bound mesh at 'buffer', from 'byteOffset' on.
+	 *
+	 * @param buffer Array buffer of InstanceData records.
+	 * @param byteOffset Where the draw's first instance starts.
+	 */
+	void bindInstances(unsigned int buffer, std::size_t byteOffset) const;
+
+	/**
+	 * @brief Issues the draw call of one of the mesh's primitives. The mesh must be bound, the program and material set up.
+	 *
+	 * @param prim One of 'primitives'.
+	 * @param instanceCount Instances to draw, more than one needs bindInstances() and the instancing permutation.
+	 */
+	void drawPrimitive(Primitive const& prim, int instanceCount = 1) const;
+
 private:
 	// OpenGL object handles
 	unsigned int vao_{}; // Vertex Array Object
 	unsigned int vbo_{}; // Vertex Buffer Object (vertex data)
 	unsigned int ebo_{}; // Element Buffer Object (index data)
+
+	bool skinned_{false}; // Has the joint stream (attributes 3 and 4)
+	std::size_t vertexBytes_{};
+	std::size_t indexBytes_{};
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <iostream>
@@ -9,20 +10,47 @@
 #include <vector>
 
 #include "BoundingBox.hpp"
+#include "PosePool.hpp"
+#include "Skeleton.hpp"
 
 class AnimationClip;
 class Mesh;
 class Node;
 class Shader;
 
+/**
+ * @brief Skin of a model: which nodes are joints and their inverse bind matrices. Models loaded from different files
+ * with the same rig share one instance (see RigStore).
+ */
+struct Rig {
+	std::uint64_t signature{};									// Joint names, hierarchy, bind pose and inverse bind matrices
+	std::vector<int> jointNodes;								// Joint index -> node index
+	std::vector<glm::mat4> inverseBindMatrices; // Per joint
+
+	std::size_t getMemoryBytes() const { return sizeof(Rig) + jointNodes.size() * sizeof(int) + inverseBindMatrices.size() * sizeof(glm::mat4); }
+};
+
 class Model {
 public:
 	Model() = default;
 	~Model();
 	void cleanup();
 
-	void draw(Shader const& shader, glm::mat4 const& modelMatrix) const;
-	void updateLocalMatrices();
+	// Draws with a plain 'model' uniform per mesh and without skinning, for shaders outside the renderer's uniform blocks
+	// (the model shaders get their per-mesh data from the Renderer's draw buffer instead, see getMeshTransform).
+	// 'pose' is the animated pose of the object being drawn (see AnimationInstance), nullptr draws the model's bind pose
+	void draw(Shader const& shader, glm::mat4 const& modelMatrix, Pose const* pose = nullptr) const;
+	void updateLocalMatrices(); // Flattens the node tree and recomposes the bind pose below, shared by every object using this model
+
+	// World matrix of one mesh of an object placed at 'modelMatrix', meshes attached to a node follow the node in 'pose'
+	glm::mat4 getMeshTransform(std::size_t mesh, glm::mat4 const& modelMatrix, Pose const& pose) const;
+
+	// World and joint matrices of 'pose' from its local TRS
+	PoseUpdateStats composePose(Pose& pose) const; // Recomposes only the dirty nodes of the pose and their subtrees
+
+	// Samples every clip at 'sampleRate' and stores a box holding all of its poses, grown by 'padding' (fraction of its size)
+	// to cover the motion between samples. Instances playing a clip with such a box skip the per-frame bounds update
+	void computeClipBounds(float sampleRate, float padding);
 
 public:
 	// Core model data
@@ -30,18 +58,22 @@ public:
 	std::vector<int> meshNodeIndices; // Mesh -> Node mapping
 	std::vector<BoundingBox> boundingBoxes;
 	BoundingBox localSpaceBBox;
+	std::vector<BoundingBox> jointBounds; // Bind space, the vertices each joint influences, empty for joints without any
+	BoundingBox unskinnedBounds{};				// Vertices without skin weights
+	std::vector<BoundingBox> clipBounds;	// Per clip, empty unless computeClipBounds ran
 
 	// Metadata
 	std::string modelName;
 
-	// Animation support
+	// Animation support, read-only once loaded. Per-object playback state lives in AnimationInstance
 	std::vector<std::shared_ptr<AnimationClip>> animations;
-	std::vector<std::shared_ptr<Node>> nodes; // node list
-	std::shared_ptr<Node> rootNode;						// used to represent the node tree
+	std::vector<std::shared_ptr<Node>> nodes; // node list, holds the bind pose TRS
+	std::shared_ptr<Node> rootNode;						// used to represent the node tree (names and children, for the UI and debug views)
+	Skeleton skeleton;												// the same tree flattened, used for all matrix work
+	PooledPose bindPose;
 
 	// Skinning data
-	std::vector<glm::mat4> inverseBindMatrices;
-	std::vector<glm::mat4> jointMatrices;
+	std::shared_ptr<Rig const> rig; // Shared between models of the same rig
+	std::size_t jointCount{};
 	std::vector<int> nodeToJointMapping;
-	std::vector<std::vector<std::pair<int, float>>> vertexJoints; // For each vertex: pairs of (jointIndex, weight)
 };
@@ -7,20 +7,14 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-class Model;
-
+/**
+ * @brief A node of a model's hierarchy as loaded, its bind pose TRS with names and children for the UI and debug views.
+ * Matrices are computed on the flattened Skeleton into a Pose.
+ */
 class Node {
 public:
 	Node(int nodeNum);
 
-	// Getters
-	glm::mat4 const& getNodeMatrix() const { return nodeMatrix_; }
-	glm::mat4 const& getLocalTRSMatrix() const { return localTRSMatrix_; }
-
-	// Operations
-	void updateLocalTRSMatrix();
-	void updateNodeMatrix(glm::mat4 const& parentMatrix);
-
 	// Hierarchy
 	int nodeNum{-1};
 	std::string nodeName;
@@ -30,18 +24,8 @@ public:
 	glm::vec3 translation{0.0f};
 	glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
 	glm::vec3 scale{1.0f};
-
-private:
-	// Matrices
-	glm::mat4 localTRSMatrix_{1.0f};
-	glm::mat4 nodeMatrix_{1.0f};
 };
 
 namespace NodeUtil {
-
-// Update node tree matrices
-void updateNodeTreeMatricesRecursive(std::shared_ptr<Node> node, glm::mat4 const& parentMatrix);
-void updateNodeListLocalTRSMatrix(std::vector<std::shared_ptr<Node>> const& nodes);
-void updateNodeListJointMatrices(Model& model);
 std::shared_ptr<Node> createRoot(int nodeNum);
 } // namespace NodeUtil
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+/**
+ * @brief Local TRS and the resulting matrices of one posed skeleton, indexed by node number and joint index.
+ * A view over a block owned by the PosePool, clips sample into the TRS arrays and the owner composes the matrices.
+ */
+struct Pose {
+	std::size_t nodeCount{};
+	std::size_t jointCount{};
+
+	glm::mat4x3* worldMatrices{}; // Model space 3x4 affine, per node
+	glm::mat4* jointMatrices{};		// Skinning matrices, per joint
+	glm::quat* rotations{};
+	glm::vec3* translations{};
+	glm::vec3* scales{};
+	std::uint8_t* dirty{}; // Per node, set when its local TRS changed since the matrices were last composed
+
+	bool empty() const { return nodeCount == 0; }
+
+	// Writers go through these so unchanged channels (e.g. constant tracks) leave their subtree clean
+	void setRotation(std::size_t node, glm::quat const& q)
+	{
+		if (rotations[node] != q) {
+			rotations[node] = q;
+			dirty[node] = 1;
+		}
+	}
+	void setTranslation(std::size_t node, glm::vec3 const& t)
+	{
+		if (translations[node] != t) {
+			translations[node] = t;
+			dirty[node] = 1;
+		}
+	}
+	void setScale(std::size_t node, glm::vec3 const& s)
+	{
+		if (scales[node] != s) {
+			scales[node] = s;
+			dirty[node] = 1;
+		}
+	}
+	void markAllDirty() { std::fill_n(dirty, nodeCount, std::uint8_t{1}); }
+	void clearDirty() { std::fill_n(dirty, nodeCount, std::uint8_t{0}); }
+};
+
+/**
+ * @brief How much of a pose the last compose actually touched.
+ */
+struct PoseUpdateStats {
+	std::size_t nodesRecomputed{};
+	std::size_t jointsRecomputed{};
+
+	bool changed() const { return nodesRecomputed > 0 || jointsRecomputed > 0; }
+	PoseUpdateStats& operator+=(PoseUpdateStats const& other)
+	{
+		nodesRecomputed += other.nodesRecomputed;
+		jointsRecomputed += other.jointsRecomputed;
+		return *this;
+	}
+};
+
+/**
+ * @brief Recycles pose blocks. Blocks of the same node and joint count share a size class and are carved from slabs,
+ * so the poses of characters spawned from one model sit next to each other and release never frees memory.
+ */
+class PosePool {
+public:
+	static PosePool& getInstance();
+
+	Pose acquire(std::size_t nodeCount, std::size_t jointCount); // Identity matrices and TRS, every node dirty
+	void release(Pose& pose);
+
+	std::size_t getBlocksInUse() const;
+	std::size_t getReservedBytes() const;
+
+private:
+	PosePool() = default;
+
+	static constexpr std::size_t kBlocksPerSlab = 8;
+
+	struct SizeClass {
+		std::size_t blockBytes{};
+		std::vector<std::unique_ptr<std::byte[]>> slabs;
+		std::vector<std::byte*> freeBlocks;
+		std::size_t blocksInUse{};
+	};
+
+	static std::size_t blockBytes_(std::size_t nodeCount, std::size_t jointCount);
+	static Pose layout_(std::byte* block, std::size_t nodeCount, std::size_t jointCount);
+
+	std::unordered_map<std::uint64_t, SizeClass> classes_; // Keyed by node count << 32 | joint count
+	mutable std::mutex mutex_;
+};
+
+/**
+ * @brief A pose acquired from the PosePool and released when it goes out of scope.
+ *
+ */
+class PooledPose {
+public:
+	PooledPose() = default;
+	PooledPose(std::size_t nodeCount, std::size_t jointCount) : pose_(PosePool::getInstance().acquire(nodeCount, jointCount)) {}
+	~PooledPose() { PosePool::getInstance().release(pose_); }
+
+	PooledPose(PooledPose const&) = delete;
+	PooledPose& operator=(PooledPose const&) = delete;
+	PooledPose(PooledPose&& other) noexcept : pose_(other.pose_) { other.pose_ = Pose{}; }
+	PooledPose& operator=(PooledPose&& other) noexcept
+	{
+		if (this != &other) {
+			PosePool::getInstance().release(pose_);
+			pose_ = other.pose_;
+			other.pose_ = Pose{};
+		}
+		return *this;
+	}
+
+	Pose& get() { return pose_; }
+	Pose const& get() const { return pose_; }
+
+private:
+	Pose pose_{};
+};
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+#include "BoundingBox.hpp"
+
 class Material;
 
 /**
@@ -10,4 +15,11 @@ struct Primitive {
 	unsigned int indexCount;	// Number of indices to draw (usually divisible by 3)
 	Material* material;				// Material to bind when drawing this primitive
 	bool doubleSided = false;
+
+	// GPU index layout, filled in by Mesh::setup
+	bool shortIndices = false;			 // 16-bit indices, relative to baseVertex
+	int baseVertex = 0;							 // Added to every index by the draw call
+	std::size_t indexByteOffset = 0; // Where the primitive starts in the GPU index buffer
+	BoundingBox bounds{};						 // Mesh space box of the vertices it draws, for per-primitive culling
+	std::uint32_t sortId = 0;				 // Unique per primitive, keeps the instances of a primitive together in the RenderQueue
 };
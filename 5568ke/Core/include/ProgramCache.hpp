@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "include_5568ke.hpp"
+
+class Shader;
+
+/**
+ * @brief Totals of the programs linked since startup, the time covers reading sources, compiling or loading a
+ * binary and linking, summed over every program.
+ */
+struct ProgramCacheStats {
+	std::size_t cachedPrograms{};		// Linked from a stored binary
+	std::size_t compiledPrograms{}; // Compiled from source (cold cache, or binaries unsupported)
+	std::size_t rejectedBinaries{}; // Stored binaries the driver refused, recompiled and replaced
+	double programMs{};
+};
+
+/**
+ * @brief Linked program binaries stored on disk (glGetProgramBinary), keyed by the program's preprocessed sources and
+ * the driver's vendor, renderer and version strings, so a driver update simply misses the cache.
+ *
+ * Between beginBatch() and endBatch() Shader only issues its compile and link, the status checks that would wait for
+ * the driver are deferred to endBatch(). With KHR_parallel_shader_compile the driver compiles the batch on its own
+ * threads meanwhile.
+ */
+class ProgramCache {
+public:
+	static ProgramCache& getInstance()
+	{
+		static ProgramCache instance;
+		return instance;
+	}
+
+	std::uint64_t makeKey(std::string const& vertSource, std::string const& fragSource);
+	bool load(std::uint64_t key, GLuint program); // Issues glProgramBinary, Shader checks the link status to see if it took
+	void store(std::uint64_t key, GLuint program);
+	void reject(std::uint64_t key); // Drops a stored binary the driver refused
+
+	bool binariesSupported();
+	void beginBatch();
+	void endBatch();
+	bool isBatching() const { return batching_; }
+	void defer(Shader* shader) { pending_.push_back(shader); }
+
+	ProgramCacheStats& getStats() { return stats_; }
+
+private:
+	ProgramCache() = default;
+	ProgramCache(ProgramCache const&) = delete;
+	ProgramCache& operator=(ProgramCache const&) = delete;
+
+	void init_(); // Needs a current context, runs on first use
+	std::string getPath_(std::uint64_t key) const;
+
+	bool initialized_{false};
+	bool binaries_{false};
+	std::string driver_; // Vendor, renderer and version, part of every key
+	std::string directory_{"cache/shaders"};
+
+	bool batching_{false};
+	std::vector<Shader*> pending_;
+	ProgramCacheStats stats_{};
+};
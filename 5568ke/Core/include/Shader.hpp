@@ -1,25 +1,91 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "include_5568ke.hpp"
 
+/**
+ * @brief A uniform of one Shader resolved once by name, typed by the value it takes. Handles stay valid across
+ * Shader::reload(), the location behind them is looked up again after every link.
+ */
+template <typename T> class UniformHandle {
+public:
+	bool valid() const { return slot_ >= 0; }
+
+private:
+	friend class Shader;
+	int slot_{-1};
+};
+
 class Shader {
 public:
-	void resetShaderPath(std::string const& vertPath, std::string const& fragPath);
+	// 'defines' are inserted as '#define NAME' after the #version line of both stages, one program per permutation
+	void resetShaderPath(std::string const& vertPath, std::string const& fragPath, std::vector<std::string> const& defines = {});
 	void reload();
+	void finishLink(); // Checks the link issued by reload(), called right away or at the end of a ProgramCache batch
 	void bind() const;
 	void unbind() const;
 
+	// Resolve a uniform once and keep the handle, setting through it skips the name lookup
+	template <typename T> UniformHandle<T> getUniform(char const* name)
+	{
+		UniformHandle<T> handle;
+		handle.slot_ = resolveSlot_(name);
+		return handle;
+	}
+
+	void set(UniformHandle<glm::mat4> handle, glm::mat4 const& mat) const;
+	void set(UniformHandle<glm::vec3> handle, glm::vec3 const& vec) const;
+	void set(UniformHandle<float> handle, float value) const;
+	void set(UniformHandle<int> handle, int value) const;
+	void set(UniformHandle<bool> handle, bool value) const;
+
+	// By name, looked up in the table reflected at link time
 	void sendMat4(char const* name, glm::mat4 const& mat) const;
 	void sendVec3(char const* name, glm::vec3 const& vec) const;
 	void sendFloat(char const* name, float value) const;
 	void sendInt(char const* name, int value) const;
-	void sendBool(char const* name, bool value) const { glUniform1i(glGetUniformLocation(program_, name), static_cast<int>(value)); }
+	void sendBool(char const* name, bool value) const;
+
+	int getUniformLocation(char const* name) const; // -1 if the program has no such active uniform
+
+	// Samplers that always read the same texture unit, set once after every link instead of per draw
+	void setSamplerUnit(char const* name, int unit);
 
 private:
+	struct UniformSlot {
+		std::string name;
+		std::uint64_t hash{};
+		int location{-1};
+	};
+
+	void compileAndLink_();
+	void reflectUniforms_();
+	void applySamplerUnits_();
+	int resolveSlot_(char const* name);
+	int slotLocation_(int slot) const;
+	void warnMissing_(char const* name, std::uint64_t hash) const;
+
 	unsigned int program_{};
 	std::string vsPath_;
 	std::string fsPath_;
+	std::vector<std::string> defines_;
+
+	// Between reload() and finishLink()
+	std::string vsSource_;
+	std::string fsSource_;
+	std::uint64_t cacheKey_{};
+	unsigned int vs_{}, fs_{};
+	bool fromCache_{false};
+	std::vector<std::pair<std::string, int>> samplerUnits_;
+
+	std::unordered_map<std::uint64_t, int> locations_; // Name hash -> location of every active uniform of the program
+	std::vector<UniformSlot> slots_;									 // Uniforms resolved through getUniform()
+	mutable std::unordered_set<std::uint64_t> warned_; // Missing uniforms already reported for this program
 };
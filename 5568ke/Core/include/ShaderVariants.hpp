@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Shader.hpp"
+
+/**
+ * @brief Feature keys of the model shaders, each one becomes a '#define' of the same name in the GLSL sources.
+ * A draw asks for the combination it needs instead of branching on uniforms in the shader.
+ */
+enum ShaderFeature : unsigned int {
+	SHADER_SKINNING = 1u << 0,				// Joint palette skinning (model.vert)
+	SHADER_DOUBLE_SIDED = 1u << 1,		// Back faces are lit from their own side (blinn.frag)
+	SHADER_OVERLAY_TEXTURE = 1u << 2, // Second texture drawn over the base one (blinn.frag)
+	SHADER_INSTANCING = 1u << 3,			// Per-instance model and normal matrices from vertex attributes (model.vert)
+};
+
+/**
+ * @brief One pair of GLSL sources compiled into a program per feature combination. Permutations are compiled the
+ * first time a draw asks for them and cached from then on.
+ */
+class ShaderVariants {
+public:
+	void resetShaderPath(std::string const& vertPath, std::string const& fragPath);
+	void reload(); // Recompiles every cached permutation
+
+	Shader const& get(unsigned int features); // Compiles the permutation on first use
+
+	// Applied to every permutation, see Shader::setSamplerUnit
+	void setSamplerUnit(char const* name, int unit);
+
+	std::size_t getVariantCount() const { return variants_.size(); }
+
+	static std::vector<std::string> getDefines(unsigned int features);
+
+private:
+	std::string vsPath_;
+	std::string fsPath_;
+	std::vector<std::pair<std::string, int>> samplerUnits_;
+	std::unordered_map<unsigned int, std::unique_ptr<Shader>> variants_;
+};
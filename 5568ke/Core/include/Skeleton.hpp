@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+class Node;
+struct Pose;
+
+/**
+ * @brief Flattened node hierarchy of a model. Nodes keep their glTF indices, the order array lists every node below the root
+ * with parents before their children, so all world matrices of a pose come out of one forward loop.
+ */
+class Skeleton {
+public:
+	void build(std::vector<std::shared_ptr<Node>> const& nodes, std::shared_ptr<Node> const& root);
+	void clear();
+	bool empty() const { return order_.empty(); }
+
+	// Composes the world matrices of the pose's dirty nodes and everything below them, flagging the whole recomposed subtree.
+	// Returns the number of nodes recomputed
+	std::size_t computeWorldMatrices(Pose& pose) const;
+
+	std::size_t getNodeCount() const { return parents_.size(); }
+	int getParent(int node) const { return parents_[node]; }
+	std::vector<int> const& getOrder() const { return order_; }
+
+	// Local TRS as a 3x4 affine matrix (glm's mat4x3: four columns of three rows)
+	static glm::mat4x3 composeTRS(glm::vec3 const& translation, glm::quat const& rotation, glm::vec3 const& scale);
+	static glm::mat4x3 multiplyAffine(glm::mat4x3 const& a, glm::mat4x3 const& b);
+
+private:
+	std::vector<int> parents_; // Per node, -1 for the root and nodes outside the tree
+	std::vector<int> order_;	 // Nodes reachable from the root, parents first
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Model;
+struct Pose;
+
+/**
+ * @brief Skinned vertex positions of one animated object on the CPU (picking, mesh-accurate collision, headless runs).
+ * The meshes are re-skinned only when the pose changed since the last update, large ones in chunks on the AnimationSystem workers.
+ */
+class SkinnedVertexCache {
+public:
+	static constexpr std::size_t kChunkSize = 4096; // Vertices per parallel job
+
+	// 'poseVersion' identifies the state of 'pose' (see AnimationInstance::getPoseVersion). Returns true when it re-skinned.
+	// Main thread only, outside of an AnimationSystem dispatch
+	bool update(Model const& model, Pose const& pose, std::uint64_t poseVersion);
+	void invalidate() { valid_ = false; }
+
+	// Positions of one mesh, indexed like its vertices, nullptr before the first update
+	glm::vec3 const* getPositions(std::size_t meshIndex) const;
+	std::size_t getVertexCount() const { return positions_.size(); }
+	std::size_t getSkinCount() const { return skinCount_; } // Updates that actually re-skinned
+
+private:
+	std::vector<glm::vec3> positions_;			// Every mesh of the model back to back
+	std::vector<std::size_t> meshOffsets_; // First position of each mesh
+	std::uint64_t version_{};
+	bool valid_{false};
+	std::size_t skinCount_{};
+};
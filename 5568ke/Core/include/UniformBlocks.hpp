@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief std140 layout of the 'Frame' uniform block of the model shaders (model.vert, blinn.frag).
+ * Written once per frame, every program linked by Shader finds it at kBinding.
+ */
+struct FrameBlock {
+	static constexpr unsigned int kBinding = 0;
+	static constexpr char const* kName = "Frame";
+
+	glm::mat4 view{1.0f};
+	glm::mat4 proj{1.0f};
+	glm::vec4 viewPos{0.0f};	// xyz
+	glm::vec4 lightPos{0.0f}; // xyz
+};
+
+/**
+ * @brief std140 layout of the 'Draw' uniform block, one record per mesh drawn in a frame. All records are uploaded
+ * together, a draw only selects its own record by binding its range at kBinding.
+ */
+struct DrawBlock {
+	static constexpr unsigned int kBinding = 1;
+	static constexpr char const* kName = "Draw";
+
+	glm::mat4 model{1.0f};
+	glm::mat4 normalMatrix{1.0f};		 // Inverse transpose of the model matrix, only the upper 3x3 is used
+	glm::ivec4 skinning{0, 0, 0, 0}; // x: first joint of the draw in the joint palette, read by the skinning permutation
+};
+
+static_assert(sizeof(FrameBlock) == 160, "FrameBlock must match the std140 layout of the shaders");
+static_assert(sizeof(DrawBlock) == 144, "DrawBlock must match the std140 layout of the shaders");
@@ -0,0 +1,251 @@
+#include "AnimationBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+#include "AnimationChannel.hpp"
+#include "AnimationClip.hpp"
+#include "AnimationInstance.hpp"
+#include "AnimationKernels.hpp"
+#include "AnimationSystem.hpp"
+#include "CompressedClip.hpp"
+#include "GameObject.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "Scene.hpp"
+#include "SkinnedVertexCache.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from dropping the lookups
+volatile std::size_t g_sink = 0;
+
+template <typename T> std::size_t linearLookup_(T const* timings, std::size_t count, float time)
+{
+	std::size_t idx = 0;
+	while (idx + 1 < count && timings[idx + 1] < time)
+		++idx;
+	return idx;
+}
+
+template <typename Fn> double measureMs_(Fn&& fn)
+{
+	auto start = Clock::now();
+	fn();
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A track's key times, float seconds for the channels and quantized units for the compressed tracks
+template <typename T> struct KeyTimes {
+	T const* times;
+	std::size_t count;
+};
+
+// Times the three lookups on every track of a clip, 'timeScale' converts the sample times to the tracks' time unit.
+// Samples are clamped into the track's own range, the same way the getters handle it
+template <typename T>
+void timeLookups_(std::vector<KeyTimes<T>> const& tracks, float timeScale, float sampleRate, int loops, AnimationBenchmark::ClipLookupResult& result)
+{
+	result.channelCount = tracks.size();
+	for (auto const& track : tracks)
+		result.keyCount += track.count;
+
+	auto forEachSample = [&](auto&& lookup) {
+		std::size_t sink = 0;
+		for (int loop = 0; loop < loops; ++loop) {
+			for (std::size_t c = 0; c < tracks.size(); ++c) {
+				KeyTimes<T> const& track = tracks[c];
+				if (track.count < 2)
+					continue;
+
+				for (std::size_t s = 0; s < result.sampleCount; ++s) {
+					float time = static_cast<float>(s) / sampleRate * timeScale;
+					if (time <= track.times[0] || time >= track.times[track.count - 1])
+						continue;
+					sink += lookup(track, c, time);
+				}
+			}
+		}
+		g_sink = g_sink + sink;
+	};
+
+	result.linearMs = measureMs_([&] {
+		forEachSample([&](KeyTimes<T> const& track, std::size_t, float time) { return linearLookup_(track.times, track.count, time); });
+	});
+
+	result.binaryMs = measureMs_([&] {
+		forEachSample([&](KeyTimes<T> const& track, std::size_t, float time) {
+			std::size_t fresh = 0;
+			return AnimationKernels::findKeyframe(track.times, track.count, time, fresh);
+		});
+	});
+
+	std::vector<std::size_t> cursors(tracks.size(), 0);
+	result.cursorMs = measureMs_([&] {
+		forEachSample([&](KeyTimes<T> const& track, std::size_t c, float time) {
+			return AnimationKernels::findKeyframe(track.times, track.count, time, cursors[c]);
+		});
+	});
+}
+
+// Skinning as the bounding box code used to do it, one glm matrix-vector product per influence
+void scalarSkin_(std::vector<Vertex> const& vertices, glm::mat4 const* jointMatrices, std::size_t jointCount, glm::vec3* out)
+{
+	for (std::size_t i = 0; i < vertices.size(); ++i) {
+		Vertex const& v = vertices[i];
+		glm::vec4 pos(v.position, 1.0f);
+		glm::vec4 skinned(0.0f);
+		float total = 0.0f;
+		for (int k = 0; k < 4; ++k) {
+			float w = v.boneWeights[k];
+			int id = v.boneIds[k];
+			if (w > 0.0f && id >= 0 && static_cast<std::size_t>(id) < jointCount) {
+				skinned += w * (jointMatrices[id] * pos);
+				total += w;
+			}
+		}
+		out[i] = total > 0.0f ? glm::vec3(skinned / total) : v.position;
+	}
+}
+
+} // namespace
+
+namespace AnimationBenchmark {
+
+std::vector<ClipLookupResult> runKeyframeLookup(Scene const& scene, float sampleRate, int loops)
+{
+	std::vector<ClipLookupResult> results;
+
+	for (auto const& go : scene.gameObjects) {
+		if (!go || !go->getModel())
+			continue;
+
+		Model const& model = *go->getModel();
+		for (auto const& clip : model.animations) {
+			float duration = clip->getDuration();
+			if (duration <= 0.0f || !clip->isResident())
+				continue; // Evicted clips have no keyframes to look up
+
+			ClipLookupResult result;
+			result.modelName = model.modelName;
+			result.clipName = clip->clipName;
+			result.sampleCount = static_cast<std::size_t>(duration * sampleRate) + 1;
+
+			// Compressed clips (the default) no longer have channels, their tracks are searched in quantized time
+			if (clip->isCompressed()) {
+				CompressedClip const& compressed = clip->getCompressed();
+				std::vector<KeyTimes<std::uint16_t>> tracks;
+				for (auto const& track : compressed.getTrackTimes())
+					tracks.push_back(KeyTimes<std::uint16_t>{track.times, track.count});
+				result.compressed = true;
+				timeLookups_(tracks, compressed.getTimeScale(), sampleRate, loops, result);
+			}
+			else {
+				std::vector<KeyTimes<float>> tracks;
+				for (auto const& channel : clip->getChannels())
+					tracks.push_back(KeyTimes<float>{channel->getTimings().data(), channel->getTimings().size()});
+				timeLookups_(tracks, 1.0f, sampleRate, loops, result);
+			}
+
+			results.push_back(std::move(result));
+		}
+	}
+
+	return results;
+}
+
+void printResults(std::vector<ClipLookupResult> const& results)
+{
+	std::cout << "[AnimationBenchmark] Keyframe lookup, " << results.size() << " clips" << std::endl;
+	for (auto const& r : results) {
+		std::cout << "  " << r.modelName << " / " << r.clipName << ": " << r.channelCount << (r.compressed ? " compressed tracks, " : " channels, ")
+							<< r.keyCount << " keys, " << r.sampleCount << " samples" << std::fixed << std::setprecision(3) << " | linear " << r.linearMs
+							<< " ms, binary " << r.binaryMs << " ms, cursor " << r.cursorMs << " ms" << std::defaultfloat << std::endl;
+	}
+}
+
+std::vector<SkinningResult> runSkinning(Scene const& scene, int loops)
+{
+	std::vector<SkinningResult> results;
+	std::set<Model const*> seen;
+	AnimationSystem& animationSystem = AnimationSystem::getInstance();
+
+	for (auto const& go : scene.gameObjects) {
+		if (!go || !go->getModel() || go->getModel()->jointCount == 0 || !seen.insert(go->getModel().get()).second)
+			continue;
+
+		Model const& model = *go->getModel();
+		Pose const& pose = go->hasAnimation() ? go->getAnimation()->getPose() : model.bindPose.get();
+		if (pose.jointCount == 0)
+			continue;
+
+		SkinningResult result;
+		result.modelName = model.modelName;
+		result.jointCount = pose.jointCount;
+		result.threadCount = animationSystem.getWorkerCount() + 1;
+		result.loops = loops;
+		for (auto const& mesh : model.meshes)
+			result.vertexCount += mesh.vertices.size();
+		if (result.vertexCount == 0)
+			continue;
+
+		std::vector<glm::vec3> out(result.vertexCount);
+		auto forEachMesh = [&](auto&& skin) {
+			glm::vec3* dst = out.data();
+			for (auto const& mesh : model.meshes) {
+				skin(mesh, dst);
+				dst += mesh.vertices.size();
+			}
+		};
+
+		result.scalarMs = measureMs_([&] {
+			for (int loop = 0; loop < loops; ++loop)
+				forEachMesh([&](Mesh const& mesh, glm::vec3* dst) { scalarSkin_(mesh.vertices, pose.jointMatrices, pose.jointCount, dst); });
+		});
+
+		result.simdMs = measureMs_([&] {
+			for (int loop = 0; loop < loops; ++loop) {
+				forEachMesh([&](Mesh const& mesh, glm::vec3* dst) {
+					AnimationKernels::skinPositions(mesh.vertices.data(), 0, mesh.vertices.size(), pose.jointMatrices, pose.jointCount, dst);
+				});
+			}
+		});
+
+		// Chunked like SkinnedVertexCache, but every loop re-skins
+		result.parallelMs = measureMs_([&] {
+			for (int loop = 0; loop < loops; ++loop) {
+				forEachMesh([&](Mesh const& mesh, glm::vec3* dst) {
+					std::size_t chunkCount = (mesh.vertices.size() + SkinnedVertexCache::kChunkSize - 1) / SkinnedVertexCache::kChunkSize;
+					animationSystem.parallelFor(chunkCount, [&](std::size_t chunk) {
+						std::size_t begin = chunk * SkinnedVertexCache::kChunkSize;
+						std::size_t end = std::min(begin + SkinnedVertexCache::kChunkSize, mesh.vertices.size());
+						AnimationKernels::skinPositions(mesh.vertices.data(), begin, end, pose.jointMatrices, pose.jointCount, dst);
+					});
+				});
+			}
+		});
+
+		g_sink = g_sink + static_cast<std::size_t>(out.back().x);
+		results.push_back(std::move(result));
+	}
+
+	return results;
+}
+
+void printResults(std::vector<SkinningResult> const& results)
+{
+	std::cout << "[AnimationBenchmark] CPU skinning, " << results.size() << " models" << std::endl;
+	for (auto const& r : results) {
+		std::cout << "  " << r.modelName << ": " << r.vertexCount << " vertices, " << r.jointCount << " joints, " << r.loops << " loops" << std::fixed
+							<< std::setprecision(3) << " | scalar " << r.scalarMs << " ms, simd " << r.simdMs << " ms, parallel " << r.parallelMs << " ms on "
+							<< r.threadCount << " threads" << std::setprecision(1) << " | Mvert/s/core: scalar " << r.scalarRate() / 1e6 << ", simd "
+							<< r.simdRate() / 1e6 << ", parallel " << r.parallelRate() / 1e6 << std::defaultfloat << std::endl;
+	}
+}
+
+} // namespace AnimationBenchmark
@@ -8,6 +8,8 @@
 
 #include <tiny_gltf.h>
 
+#include "AnimationKernels.hpp"
+
 void AnimationChannel::loadChannelData(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel)
 {
 	// std::cout << "[AnimationChannel INFO] AnimationChannel::loadChannelData - Starting" << std::endl;
@@ -276,7 +278,12 @@ float AnimationChannel::getMaxTime() const
 	return timings_.back();
 }
 
-glm::vec3 AnimationChannel::getScaling(float time) const
+std::size_t AnimationChannel::findKeyframe(float time, std::size_t& cursor) const
+{
+	return AnimationKernels::findKeyframe(timings_.data(), timings_.size(), time, cursor);
+}
+
+glm::vec3 AnimationChannel::getScaling(float time, std::size_t& cursor) const
 {
 	if (scalings_.empty()) {
 		return glm::vec3(1.0f);
@@ -291,16 +298,8 @@ glm::vec3 AnimationChannel::getScaling(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
-	size_t prevIdx = nextIdx - 1;
-
-	// Handle special case when indices are the same
-	if (prevIdx == nextIdx) {
-		return scalings_[prevIdx];
-	}
+	size_t prevIdx = findKeyframe(time, cursor);
+	size_t nextIdx = prevIdx + 1;
 
 	// Interpolate based on interpolation type
 	glm::vec3 result(1.0f);
@@ -342,7 +341,7 @@ glm::vec3 AnimationChannel::getScaling(float time) const
 	return result;
 }
 
-glm::vec3 AnimationChannel::getTranslation(float time) const
+glm::vec3 AnimationChannel::getTranslation(float time, std::size_t& cursor) const
 {
 	if (translations_.empty()) {
 		return glm::vec3(0.0f);
@@ -357,16 +356,8 @@ glm::vec3 AnimationChannel::getTranslation(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
-	size_t prevIdx = nextIdx - 1;
-
-	// Handle special case when indices are the same
-	if (prevIdx == nextIdx) {
-		return translations_[prevIdx];
-	}
+	size_t prevIdx = findKeyframe(time, cursor);
+	size_t nextIdx = prevIdx + 1;
 
 	// Interpolate based on interpolation type
 	glm::vec3 result(0.0f);
@@ -408,7 +399,7 @@ glm::vec3 AnimationChannel::getTranslation(float time) const
 	return result;
 }
 
-glm::quat AnimationChannel::getRotation(float time) const
+glm::quat AnimationChannel::getRotation(float time, std::size_t& cursor) const
 {
 	if (rotations_.empty()) {
 		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
@@ -423,16 +414,8 @@ glm::quat AnimationChannel::getRotation(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
-	size_t prevIdx = nextIdx - 1;
-
-	// Handle special case when indices are the same
-	if (prevIdx == nextIdx) {
-		return rotations_[prevIdx];
-	}
+	size_t prevIdx = findKeyframe(time, cursor);
+	size_t nextIdx = prevIdx + 1;
 
 	// Interpolate based on interpolation type
 	glm::quat result(1.0f, 0.0f, 0.0f, 0.0f);
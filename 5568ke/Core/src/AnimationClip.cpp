@@ -3,16 +3,213 @@
 #include "AnimationClip.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <unordered_map>
 
 #include <tiny_gltf.h>
 
 #include "AnimationChannel.hpp"
 #include "AnimationTypes.hpp"
-#include "Node.hpp"
+#include "ClipResidency.hpp"
+#include "CompiledClip.hpp"
+#include "PosePool.hpp"
+
+/**
+ * @brief What a lazily created clip keeps until it is decoded: the animation and a copy of only the accessors it reads,
+ * packed into a single buffer, so the decoder runs the same channel loading code as the glTF loader.
+ */
+struct ClipSource {
+	tinygltf::Model data;
+	tinygltf::Animation animation;
+	std::vector<std::shared_ptr<Node>> nodes; // Bind pose the clip is compressed against
+	bool compress{false};
+	float tolerance{};
+};
+
+namespace {
+
+// Copies one accessor's bytes into the source's buffer, returns its index in the source or -1
+int packAccessor(ClipSource& source, tinygltf::Model const& model, int accessorIndex, std::unordered_map<int, int>& packed)
+{
+	if (auto it = packed.find(accessorIndex); it != packed.end())
+		return it->second;
+	if (accessorIndex < 0 || static_cast<std::size_t>(accessorIndex) >= model.accessors.size())
+		return -1;
+
+	tinygltf::Accessor const& accessor = model.accessors[accessorIndex];
+	if (accessor.bufferView < 0 || static_cast<std::size_t>(accessor.bufferView) >= model.bufferViews.size())
+		return -1;
+	tinygltf::BufferView const& view = model.bufferViews[accessor.bufferView];
+	if (view.buffer < 0 || static_cast<std::size_t>(view.buffer) >= model.buffers.size())
+		return -1;
+	std::vector<unsigned char> const& bytes = model.buffers[view.buffer].data;
+
+	int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	int componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+	if (componentSize <= 0 || componentCount <= 0 || accessor.count == 0)
+		return -1;
+
+	std::size_t elementSize = static_cast<std::size_t>(componentSize * componentCount);
+	std::size_t stride = view.byteStride > 0 ? view.byteStride : elementSize;
+	std::size_t begin = view.byteOffset + accessor.byteOffset;
+	std::size_t size = (accessor.count - 1) * stride + elementSize;
+	if (begin + size > bytes.size())
+		return -1;
+
+	std::vector<unsigned char>& buffer = source.data.buffers[0].data;
+	tinygltf::BufferView packedView;
+	packedView.buffer = 0;
+	packedView.byteOffset = buffer.size();
+	packedView.byteLength = size;
+	packedView.byteStride = view.byteStride;
+	buffer.insert(buffer.end(), bytes.begin() + begin, bytes.begin() + begin + size);
+
+	tinygltf::Accessor packedAccessor = accessor;
+	packedAccessor.bufferView = static_cast<int>(source.data.bufferViews.size());
+	packedAccessor.byteOffset = 0;
+	source.data.bufferViews.push_back(packedView);
+
+	int index = static_cast<int>(source.data.accessors.size());
+	source.data.accessors.push_back(packedAccessor);
+	packed[accessorIndex] = index;
+	return index;
+}
+
+// Keyframe times are sorted, the last one is the end of the channel
+float lastKeyTime(tinygltf::Model const& data, int accessorIndex)
+{
+	tinygltf::Accessor const& accessor = data.accessors[accessorIndex];
+	if (!accessor.maxValues.empty())
+		return static_cast<float>(accessor.maxValues[0]);
+	if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+		return 0.0f;
+
+	tinygltf::BufferView const& view = data.bufferViews[accessor.bufferView];
+	std::size_t stride = view.byteStride > 0 ? view.byteStride : sizeof(float);
+	float time = 0.0f;
+	std::memcpy(&time, data.buffers[0].data.data() + view.byteOffset + (accessor.count - 1) * stride, sizeof(float));
+	return time;
+}
+
+} // namespace
 
 AnimationClip::AnimationClip(std::string const& name) : clipName(name) {}
 
+std::shared_ptr<AnimationClip> AnimationClip::createLazy(std::string const& name, tinygltf::Model const& model, tinygltf::Animation const& anim,
+																												 std::vector<std::shared_ptr<Node>> const& nodes, bool compress, float tolerance)
+{
+	auto source = std::make_shared<ClipSource>();
+	source->data.buffers.emplace_back();
+	source->animation.name = anim.name;
+	source->nodes = nodes;
+	source->compress = compress;
+	source->tolerance = tolerance;
+
+	// One sampler per kept channel, accessors shared by several samplers are packed once
+	std::unordered_map<int, int> packed;
+	float duration = 0.0f;
+	for (auto const& channel : anim.channels) {
+		if (channel.target_node < 0 || static_cast<std::size_t>(channel.target_node) >= nodes.size())
+			continue;
+		if (channel.sampler < 0 || static_cast<std::size_t>(channel.sampler) >= anim.samplers.size())
+			continue;
+
+		tinygltf::AnimationSampler sampler = anim.samplers[channel.sampler];
+		sampler.input = packAccessor(*source, model, sampler.input, packed);
+		sampler.output = packAccessor(*source, model, sampler.output, packed);
+		if (sampler.input < 0 || sampler.output < 0)
+			continue;
+
+		tinygltf::AnimationChannel packedChannel = channel;
+		packedChannel.sampler = static_cast<int>(source->animation.samplers.size());
+		source->animation.samplers.push_back(sampler);
+		source->animation.channels.push_back(packedChannel);
+		duration = std::max(duration, lastKeyTime(source->data, sampler.input));
+	}
+
+	if (source->animation.channels.empty() || duration <= 0.0f)
+		return nullptr;
+
+	auto clip = std::make_shared<AnimationClip>(name);
+	clip->source_ = std::move(source);
+	clip->duration_ = duration;
+	clip->residency_.store(ClipResidencyState::EVICTED, std::memory_order_relaxed);
+	ClipResidency::getInstance().track(clip);
+	return clip;
+}
+
+std::size_t AnimationClip::getSourceBytes() const { return source_ ? source_->data.buffers[0].data.size() : 0; }
+
+void AnimationClip::requestResident() const
+{
+	ClipResidencyState expected = ClipResidencyState::EVICTED;
+	if (!residency_.compare_exchange_strong(expected, ClipResidencyState::DECODING, std::memory_order_acq_rel))
+		return; // Resident or already queued
+
+	// Residency is bookkeeping on the side of the clip's data, the manager needs a handle it can install into
+	auto self = std::const_pointer_cast<AnimationClip>(weak_from_this().lock());
+	if (self)
+		ClipResidency::getInstance().request(std::move(self));
+	else
+		residency_.store(ClipResidencyState::EVICTED, std::memory_order_release);
+}
+
+std::shared_ptr<AnimationClip> AnimationClip::decode_() const
+{
+	auto decoded = std::make_shared<AnimationClip>(clipName);
+	for (auto const& channel : source_->animation.channels) {
+		try {
+			decoded->addChannel(source_->data, source_->animation, channel);
+		} catch (...) {
+			// std::cout << "[AnimationClip ERROR] Failed to decode a channel of '" << clipName << "'" << std::endl;
+		}
+	}
+
+	if (source_->compress)
+		decoded->compress(source_->nodes, source_->tolerance);
+	else
+		decoded->compile();
+
+	float bakeRate = bakeRate_.load(std::memory_order_relaxed);
+	if (bakeRate > 0.0f)
+		decoded->bake(bakeRate);
+	return decoded;
+}
+
+std::shared_ptr<AnimationClip const> AnimationClip::decodeNow() const
+{
+	if (isResident())
+		return shared_from_this();
+	return decode_();
+}
+
+void AnimationClip::install_(AnimationClip& decoded)
+{
+	channels_ = std::move(decoded.channels_);
+	compiled_ = std::move(decoded.compiled_);
+	compressed_ = std::move(decoded.compressed_);
+	baked_ = std::move(decoded.baked_);
+	residency_.store(ClipResidencyState::RESIDENT, std::memory_order_release);
+
+	// A bake requested while the decode was running
+	float bakeRate = bakeRate_.load(std::memory_order_relaxed);
+	if (bakeRate > 0.0f && !baked_.isBaked())
+		baked_.bake(*this, bakeRate);
+}
+
+void AnimationClip::evict_()
+{
+	if (!source_)
+		return;
+
+	channels_.clear();
+	compiled_.clear();
+	compressed_.clear();
+	baked_.clear();
+	residency_.store(ClipResidencyState::EVICTED, std::memory_order_release);
+}
+
 void AnimationClip::addChannel(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel)
 {
 	// std::cout << "[AnimationClip INFO] AnimationClip::addChannel - Creating channel" << std::endl;
@@ -23,6 +220,8 @@ void AnimationClip::addChannel(tinygltf::Model const& model, tinygltf::Animation
 		animChannel->loadChannelData(model, anim, channel);
 		// std::cout << "[AnimationClip INFO] AnimationClip::addChannel - Channel data loaded successfully" << std::endl;
 		channels_.push_back(animChannel);
+		compiled_.clear();
+		baked_.clear();
 	} catch (std::exception const& e) {
 		// std::cout << "[AnimationClip ERROR] AnimationClip::addChannel - Exception: " << e.what() << std::endl;
 		throw;
@@ -32,75 +231,110 @@ void AnimationClip::addChannel(tinygltf::Model const& model, tinygltf::Animation
 	}
 }
 
-void AnimationClip::setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time)
+void AnimationClip::compile() { compiled_.compile(channels_); }
+
+void AnimationClip::bake(float sampleRate)
 {
-	if (nodes.empty() || channels_.empty()) {
+	bakeRate_.store(sampleRate, std::memory_order_relaxed);
+	if (!isResident()) {
+		requestResident(); // Baked by the decoder
 		return;
 	}
 
-	// std::cout << "[AnimationClip] Setting frame at time " << time << " for " << clipName << std::endl;
+	if (!compressed_.isCompressed() && !compiled_.isCompiled())
+		compile();
+	baked_.bake(*this, sampleRate);
+}
 
-	// Apply all channels
-	for (auto const& channel : channels_) {
-		if (!channel)
-			continue; // Skip invalid channels
-
-		int targetNode = channel->targetNode;
-		if (targetNode < 0 || static_cast<std::size_t>(targetNode) >= nodes.size() || !nodes[targetNode])
-			continue; // Skip invalid target nodes
-
-		auto& node = nodes[targetNode];
-
-		// Get the node's current transforms for debugging
-		glm::vec3 oldTranslation = node->translation;
-		glm::vec3 oldScale = node->scale;
-
-		// Apply the animation transforms
-		switch (channel->targetPath) {
-		case TargetPath::ROTATION:
-			node->rotation = channel->getRotation(time);
-			break;
-		case TargetPath::TRANSLATION:
-			node->translation = channel->getTranslation(time);
-			break;
-		case TargetPath::SCALE:
-			node->scale = channel->getScaling(time);
-			break;
-		}
+void AnimationClip::clearBake()
+{
+	bakeRate_.store(0.0f, std::memory_order_relaxed);
+	baked_.clear();
+}
 
-		// Debug output for significant changes
-		if (glm::length(node->translation - oldTranslation) > 1.0f) {
-			// std::cout << "[AnimationClip WARNING] Large translation change in node " << targetNode << ": from " << glm::length(oldTranslation) << " to "
-			// << glm::length(node->translation) << std::endl;
-		}
+void AnimationClip::compress(std::vector<std::shared_ptr<Node>> const& nodes, float tolerance)
+{
+	if (channels_.empty())
+		return;
 
-		if (glm::length(node->scale - oldScale) > 1.0f) {
-			// std::cout << "[AnimationClip WARNING] Large scale change in node " << targetNode << ": from " << glm::length(oldScale) << " to "
-			// << glm::length(node->scale) << std::endl;
-		}
+	compressed_.compress(channels_, nodes, tolerance);
+
+	// The compressed tracks are the clip's only keyframe data from now on
+	channels_.clear();
+	compiled_.clear();
+}
+
+void AnimationClip::evaluateKeyframes(Pose& pose, float time, std::size_t* cursors) const
+{
+	if (compressed_.isCompressed())
+		compressed_.evaluate(pose, time, cursors);
+	else
+		compiled_.evaluate(pose, time, cursors);
+}
+
+std::vector<int> AnimationClip::getTargetNodes(TargetPath path) const
+{
+	return compressed_.isCompressed() ? compressed_.getTargetNodes(path) : compiled_.getTargetNodes(path);
+}
+
+std::size_t AnimationClip::getChannelCount() const { return compressed_.isCompressed() ? compressed_.getChannelCount() : channels_.size(); }
+
+std::size_t AnimationClip::getMemoryBytes() const
+{
+	std::size_t bytes = sizeof(*this) + compiled_.getMemoryBytes() + baked_.getReport().bytes;
+	if (compressed_.isCompressed())
+		bytes += compressed_.getReport().compressedBytes;
+	for (auto const& channel : channels_) {
+		bytes += sizeof(AnimationChannel) + channel->getTimings().size() * sizeof(float);
+		bytes += (channel->getTranslations().size() + channel->getScalings().size()) * sizeof(glm::vec3) + channel->getRotations().size() * sizeof(glm::quat);
 	}
+	return bytes;
+}
 
-	// Update all nodes' local matrices
-	NodeUtil::updateNodeListLocalTRSMatrix(nodes);
+void AnimationClip::setAnimationFrame(Pose& pose, float time) const
+{
+	// One-off sample (e.g. a seek from the UI): every channel starts from a fresh cursor
+	applyFrame_(pose, time, nullptr);
+}
 
-	// Second pass to update global matrices starting from the root
-	// First find the root node (usually node 0)
-	std::shared_ptr<Node> rootNode;
-	for (auto const& node : nodes) {
-		if (node && node->nodeNum == 0) {
-			rootNode = node;
-			break;
-		}
+void AnimationClip::setAnimationFrame(Pose& pose, float time, AnimationCursor& cursor) const
+{
+	// A cursor that was used with another clip is simply re-seated, every cached key is validated on use
+	if (cursor.keys.size() != getChannelCount())
+		cursor.keys.assign(getChannelCount(), 0);
+
+	applyFrame_(pose, time, cursor.keys.data());
+}
+
+void AnimationClip::applyFrame_(Pose& pose, float time, std::size_t* cursors) const
+{
+	if (!isResident()) {
+		requestResident(); // The pose holds until the decoded clip is installed
+		return;
 	}
+	lastUsed_.store(ClipResidency::getInstance().now(), std::memory_order_relaxed);
 
-	// If root node was found, update matrices starting from it
-	if (rootNode) {
-		NodeUtil::updateNodeTreeMatricesRecursive(rootNode, glm::mat4(1.0f));
+	if (pose.empty() || getChannelCount() == 0) {
+		return;
 	}
+
+	// std::cout << "[AnimationClip] Setting frame at time " << time << " for " << clipName << std::endl;
+
+	// Baked clips read their pose tables, otherwise every channel is sampled in one batched pass over the keyframe tracks
+	if (baked_.isBaked())
+		baked_.sample(pose, time);
+	else
+		evaluateKeyframes(pose, time, cursors);
 }
 
 float AnimationClip::getDuration() const
 {
+	if (source_) {
+		return duration_;
+	}
+	if (compressed_.isCompressed()) {
+		return compressed_.getDuration();
+	}
 	if (channels_.empty()) {
 		return 0.0f;
 	}
@@ -0,0 +1,278 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "AnimationInstance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "AnimationClip.hpp"
+#include "AnimationKernels.hpp"
+#include "Model.hpp"
+
+namespace {
+
+void copyLocalTRS(Pose const& source, Pose& target)
+{
+	if (source.nodeCount != target.nodeCount)
+		return;
+
+	std::copy_n(source.translations, target.nodeCount, target.translations);
+	std::copy_n(source.rotations, target.nodeCount, target.rotations);
+	std::copy_n(source.scales, target.nodeCount, target.scales);
+	target.markAllDirty();
+}
+
+} // namespace
+
+AnimationInstance::AnimationInstance(std::shared_ptr<Model> model) : model_(std::move(model)), pose_(model_->nodes.size(), model_->jointCount)
+{
+	resetToBindPose();
+}
+
+bool AnimationInstance::validClip_(int clipIndex) const
+{
+	return clipIndex >= 0 && static_cast<std::size_t>(clipIndex) < model_->animations.size() && model_->animations[clipIndex];
+}
+
+float AnimationInstance::getClipDuration() const { return validClip_(clipIndex_) ? model_->animations[clipIndex_]->getDuration() : 0.0f; }
+
+float AnimationInstance::wrapTime_(int clipIndex, float time) const
+{
+	float duration = model_->animations[clipIndex]->getDuration();
+	return duration > 0.0f ? std::fmod(time, duration) : 0.0f;
+}
+
+void AnimationInstance::play(int clipIndex, float startTime)
+{
+	if (!validClip_(clipIndex)) {
+		// std::cout << "[AnimationInstance ERROR] Invalid clip index " << clipIndex << std::endl;
+		stop();
+		return;
+	}
+
+	clipIndex_ = clipIndex;
+	time_ = startTime;
+	playing_ = true;
+	fadeDuration_ = 0.0f;
+	sample_(clipIndex_, time_);
+}
+
+void AnimationInstance::crossfade(int clipIndex, float duration, float startTime)
+{
+	if (!validClip_(clipIndex))
+		return;
+
+	Pose const& pose = pose_.get();
+	if (duration <= 0.0f || !validClip_(clipIndex_) || pose.empty()) {
+		play(clipIndex, startTime);
+		return;
+	}
+
+	if (fromPose_.get().nodeCount != pose.nodeCount) {
+		fromPose_ = PooledPose(pose.nodeCount, pose.jointCount);
+		toPose_ = PooledPose(pose.nodeCount, pose.jointCount);
+	}
+
+	// What is on screen becomes the outgoing pose. Mid-fade that is the blend of the two clips, which is held as it is
+	// instead of jumping to either clip; otherwise the current clip keeps playing underneath the fade
+	copyLocalTRS(pose, fromPose_.get());
+	if (isCrossfading()) {
+		fromClipIndex_ = -1;
+		cursor_ = AnimationCursor{};
+	}
+	else {
+		fromClipIndex_ = clipIndex_;
+		fromTime_ = time_;
+		std::swap(fromCursor_, cursor_);
+	}
+
+	// The incoming clip starts from the bind pose so nodes it does not animate end up at rest
+	copyLocalTRS(model_->bindPose.get(), toPose_.get());
+	clipIndex_ = clipIndex;
+	time_ = startTime;
+	fadeTime_ = 0.0f;
+	fadeDuration_ = duration;
+	playing_ = true;
+	sampleCrossfade_();
+}
+
+void AnimationInstance::stop()
+{
+	playing_ = false;
+	fadeDuration_ = 0.0f;
+	time_ = 0.0f;
+	resetToBindPose();
+}
+
+void AnimationInstance::advance(float dt)
+{
+	lodFrame_ = 0;
+	dt += lodSkippedTime_;
+	lodSkippedTime_ = 0.0f;
+	step_(dt);
+}
+
+void AnimationInstance::advanceReduced(float dt, int interval, bool interpolate)
+{
+	if (!playing_ || !validClip_(clipIndex_))
+		return;
+
+	if (interval <= 1) {
+		advance(dt);
+		return;
+	}
+
+	Pose& pose = pose_.get();
+	interpolate = interpolate && pose.jointCount > 0;
+
+	// In between two re-poses
+	if (lodFrame_ > 0 && lodFrame_ < interval) {
+		++lodFrame_;
+		lastUpdate_ = PoseUpdateStats{};
+		if (paletteBlending_)
+			blendPalette_(static_cast<float>(lodFrame_) / static_cast<float>(interval));
+		else
+			lodSkippedTime_ += dt;
+		return;
+	}
+
+	lodFrame_ = 1;
+	if (!interpolate) {
+		step_(dt + lodSkippedTime_);
+		lodSkippedTime_ = 0.0f;
+		return;
+	}
+
+	// Re-pose a whole interval ahead and start blending from what is on screen now
+	palettePrev_.assign(pose.jointMatrices, pose.jointMatrices + pose.jointCount);
+	step_(dt * static_cast<float>(interval) + lodSkippedTime_);
+	lodSkippedTime_ = 0.0f;
+	paletteNext_.assign(pose.jointMatrices, pose.jointMatrices + pose.jointCount);
+	paletteBlending_ = true;
+	blendPalette_(1.0f / static_cast<float>(interval));
+}
+
+void AnimationInstance::blendPalette_(float weight)
+{
+	Pose& pose = pose_.get();
+	for (std::size_t j = 0; j < pose.jointCount; ++j) {
+		for (int c = 0; c < 4; ++c)
+			pose.jointMatrices[j][c] = glm::mix(palettePrev_[j][c], paletteNext_[j][c], weight);
+	}
+	++poseVersion_;
+}
+
+SkinnedVertexCache const& AnimationInstance::getSkinnedVertices()
+{
+	skinnedVertices_.update(*model_, pose_.get(), poseVersion_);
+	return skinnedVertices_;
+}
+
+void AnimationInstance::step_(float dt)
+{
+	if (!playing_ || !validClip_(clipIndex_))
+		return;
+
+	time_ = wrapTime_(clipIndex_, time_ + dt * speed_);
+	if (!isCrossfading()) {
+		sample_(clipIndex_, time_);
+		return;
+	}
+
+	if (fromClipIndex_ >= 0)
+		fromTime_ = wrapTime_(fromClipIndex_, fromTime_ + dt * speed_);
+	fadeTime_ += dt;
+	sampleCrossfade_();
+}
+
+void AnimationInstance::setFrame(int clipIndex, float time)
+{
+	if (!validClip_(clipIndex))
+		return;
+
+	clipIndex_ = clipIndex;
+	time_ = time;
+	fadeDuration_ = 0.0f;
+	sample_(clipIndex_, time_);
+}
+
+void AnimationInstance::resetToBindPose()
+{
+	// The model's bind pose is the rest pose the clips were authored against
+	copyLocalTRS(model_->bindPose.get(), pose_.get());
+	composeMatrices_(false);
+}
+
+void AnimationInstance::sample_(int clipIndex, float time)
+{
+	model_->animations[clipIndex]->setAnimationFrame(pose_.get(), time, cursor_);
+	composeMatrices_();
+}
+
+void AnimationInstance::sampleCrossfade_()
+{
+	// Two clip samples and one blend pass, the output pose is composed once. A held outgoing pose is not sampled
+	if (fromClipIndex_ >= 0)
+		model_->animations[fromClipIndex_]->setAnimationFrame(fromPose_.get(), fromTime_, fromCursor_);
+	model_->animations[clipIndex_]->setAnimationFrame(toPose_.get(), time_, cursor_);
+
+	if (fadeTime_ >= fadeDuration_) {
+		// Fully faded in, the incoming pose is the output and later frames sample straight into it
+		copyLocalTRS(toPose_.get(), pose_.get());
+		fadeDuration_ = 0.0f;
+	}
+	else {
+		AnimationKernels::blendPoses(fromPose_.get(), toPose_.get(), fadeTime_ / fadeDuration_, pose_.get());
+	}
+	composeMatrices_();
+}
+
+void AnimationInstance::composeMatrices_(bool clipPose)
+{
+	Pose& pose = pose_.get();
+	if (pose.empty()) {
+		lastUpdate_ = PoseUpdateStats{};
+		return;
+	}
+
+	// Joints the compose below leaves alone must hold their sampled matrices, not a blended palette
+	if (paletteBlending_) {
+		std::copy(paletteNext_.begin(), paletteNext_.end(), pose.jointMatrices);
+		paletteBlending_ = false;
+		++poseVersion_;
+	}
+
+	// A frame that moved nothing (constant tracks, a held pose) keeps its matrices and bounds
+	lastUpdate_ = model_->composePose(pose);
+	if (!lastUpdate_.changed())
+		return;
+	++poseVersion_;
+	if (!clipPose || !clipBounds_(localBBox_))
+		localBBox_ = BBoxUtil::computeLocalBBox(*model_, pose);
+}
+
+bool AnimationInstance::clipBounds_(BoundingBox& out) const
+{
+	auto bounds = [&](int clipIndex) -> BoundingBox const* {
+		if (clipIndex < 0 || static_cast<std::size_t>(clipIndex) >= model_->clipBounds.size() || BBoxUtil::isEmptyBBox(model_->clipBounds[clipIndex]))
+			return nullptr;
+		return &model_->clipBounds[clipIndex];
+	};
+
+	BoundingBox const* current = bounds(clipIndex_);
+	if (!current)
+		return false;
+
+	// A crossfaded pose lies between its two clips, a held blend has no precomputed bounds
+	if (isCrossfading()) {
+		BoundingBox const* from = bounds(fromClipIndex_);
+		if (!from)
+			return false;
+		out = BBoxUtil::mergeBBox(*current, *from);
+		return true;
+	}
+
+	out = *current;
+	return true;
+}
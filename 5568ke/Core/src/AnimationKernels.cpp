@@ -0,0 +1,329 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "AnimationKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "PosePool.hpp"
+#include "Vertex.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Thin wrappers so the kernels below are written once for AVX, SSE and plain scalar builds
+#if defined(__AVX__)
+using Batch = __m256;
+constexpr std::size_t kBatchWidth = 8;
+inline Batch load(float const* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Batch v) { _mm256_storeu_ps(p, v); }
+inline Batch set1(float v) { return _mm256_set1_ps(v); }
+inline Batch add(Batch a, Batch b) { return _mm256_add_ps(a, b); }
+inline Batch sub(Batch a, Batch b) { return _mm256_sub_ps(a, b); }
+inline Batch mul(Batch a, Batch b) { return _mm256_mul_ps(a, b); }
+inline Batch div(Batch a, Batch b) { return _mm256_div_ps(a, b); }
+inline Batch sqrt(Batch a) { return _mm256_sqrt_ps(a); }
+#elif defined(__SSE2__) || defined(_M_X64)
+using Batch = __m128;
+constexpr std::size_t kBatchWidth = 4;
+inline Batch load(float const* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Batch v) { _mm_storeu_ps(p, v); }
+inline Batch set1(float v) { return _mm_set1_ps(v); }
+inline Batch add(Batch a, Batch b) { return _mm_add_ps(a, b); }
+inline Batch sub(Batch a, Batch b) { return _mm_sub_ps(a, b); }
+inline Batch mul(Batch a, Batch b) { return _mm_mul_ps(a, b); }
+inline Batch div(Batch a, Batch b) { return _mm_div_ps(a, b); }
+inline Batch sqrt(Batch a) { return _mm_sqrt_ps(a); }
+#else
+using Batch = float;
+constexpr std::size_t kBatchWidth = 1;
+inline Batch load(float const* p) { return *p; }
+inline void store(float* p, Batch v) { *p = v; }
+inline Batch set1(float v) { return v; }
+inline Batch add(Batch a, Batch b) { return a + b; }
+inline Batch sub(Batch a, Batch b) { return a - b; }
+inline Batch mul(Batch a, Batch b) { return a * b; }
+inline Batch div(Batch a, Batch b) { return a / b; }
+inline Batch sqrt(Batch a) { return std::sqrt(a); }
+#endif
+
+thread_local AnimationKernels::Staging t_staging;
+
+// Joints of one vertex with their weights renormalized, joints out of range get weight 0 and index 0. False when no joint is left
+inline bool skinWeights(Vertex const& v, std::size_t jointCount, int ids[4], float weights[4])
+{
+	float total = 0.0f;
+	for (int i = 0; i < 4; ++i) {
+		int id = v.boneIds[i];
+		bool valid = v.boneWeights[i] > 0.0f && id >= 0 && static_cast<std::size_t>(id) < jointCount;
+		ids[i] = valid ? id : 0;
+		weights[i] = valid ? v.boneWeights[i] : 0.0f;
+		total += weights[i];
+	}
+
+	if (total <= 0.0f)
+		return false;
+	float inverse = 1.0f / total;
+	for (int i = 0; i < 4; ++i)
+		weights[i] *= inverse;
+	return true;
+}
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+// Blended matrix of one vertex, one column per register, applied to its position
+inline __m128 skinVertex(Vertex const& v, glm::mat4 const* jointMatrices, int const ids[4], float const weights[4])
+{
+	__m128 columns[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+	for (int i = 0; i < 4; ++i) {
+		float const* m = &jointMatrices[ids[i]][0][0];
+		__m128 w = _mm_set1_ps(weights[i]);
+		for (int c = 0; c < 4; ++c)
+			columns[c] = _mm_add_ps(columns[c], _mm_mul_ps(w, _mm_loadu_ps(m + c * 4)));
+	}
+
+	__m128 result = _mm_add_ps(columns[3], _mm_mul_ps(columns[0], _mm_set1_ps(v.position.x)));
+	result = _mm_add_ps(result, _mm_mul_ps(columns[1], _mm_set1_ps(v.position.y)));
+	return _mm_add_ps(result, _mm_mul_ps(columns[2], _mm_set1_ps(v.position.z)));
+}
+
+inline void storePosition(glm::vec3& out, __m128 p)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, p);
+	out = glm::vec3(lanes[0], lanes[1], lanes[2]);
+}
+#endif
+
+#if defined(__AVX__)
+// Two vertices per register pair, the low half holds the first one
+inline __m256 pair(__m128 low, __m128 high) { return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1); }
+
+inline __m256 skinVertexPair(Vertex const& a, Vertex const& b, glm::mat4 const* jointMatrices, int const idsA[4], float const weightsA[4],
+														 int const idsB[4], float const weightsB[4])
+{
+	__m256 columns[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+	for (int i = 0; i < 4; ++i) {
+		float const* ma = &jointMatrices[idsA[i]][0][0];
+		float const* mb = &jointMatrices[idsB[i]][0][0];
+		__m256 w = pair(_mm_set1_ps(weightsA[i]), _mm_set1_ps(weightsB[i]));
+		for (int c = 0; c < 4; ++c)
+			columns[c] = _mm256_add_ps(columns[c], _mm256_mul_ps(w, pair(_mm_loadu_ps(ma + c * 4), _mm_loadu_ps(mb + c * 4))));
+	}
+
+	__m256 x = pair(_mm_set1_ps(a.position.x), _mm_set1_ps(b.position.x));
+	__m256 y = pair(_mm_set1_ps(a.position.y), _mm_set1_ps(b.position.y));
+	__m256 z = pair(_mm_set1_ps(a.position.z), _mm_set1_ps(b.position.z));
+	__m256 result = _mm256_add_ps(columns[3], _mm256_mul_ps(columns[0], x));
+	result = _mm256_add_ps(result, _mm256_mul_ps(columns[1], y));
+	return _mm256_add_ps(result, _mm256_mul_ps(columns[2], z));
+}
+#endif
+
+} // namespace
+
+namespace AnimationKernels {
+
+void Staging::reserve(std::size_t laneCount)
+{
+	stride = (laneCount + kBatchWidth - 1) / kBatchWidth * kBatchWidth;
+	if (data.size() < stride * kPlaneCount)
+		data.resize(stride * kPlaneCount);
+}
+
+void Staging::padLanes(std::size_t laneCount)
+{
+	for (std::size_t i = laneCount; i < stride; ++i) {
+		plane(kFactorPlane)[i] = 0.0f;
+		for (int p = 0; p < kInputPlanes; ++p)
+			plane(p)[i] = 0.0f;
+		plane(3)[i] = 1.0f;
+		plane(4 + 3)[i] = 1.0f;
+		plane(3 * 4 + 3)[i] = 1.0f;
+	}
+}
+
+Staging& threadStaging() { return t_staging; }
+
+void lerp(Staging& s, int componentCount)
+{
+	float const* t = s.plane(Staging::kFactorPlane);
+	for (int c = 0; c < componentCount; ++c) {
+		float const* a = s.plane(c);
+		float const* b = s.plane(4 + c);
+		float* out = s.plane(Staging::kOutputPlane + c);
+		for (std::size_t i = 0; i < s.stride; i += kBatchWidth) {
+			Batch va = load(a + i);
+			store(out + i, add(va, mul(sub(load(b + i), va), load(t + i))));
+		}
+	}
+}
+
+void hermite(Staging& s, int componentCount)
+{
+	float const* t = s.plane(Staging::kFactorPlane);
+	for (int c = 0; c < componentCount; ++c) {
+		float const* ca = s.plane(0 * 4 + c);
+		float const* cb = s.plane(1 * 4 + c);
+		float const* cc = s.plane(2 * 4 + c);
+		float const* cd = s.plane(3 * 4 + c);
+		float* out = s.plane(Staging::kOutputPlane + c);
+		for (std::size_t i = 0; i < s.stride; i += kBatchWidth) {
+			Batch vt = load(t + i);
+			Batch r = add(mul(load(ca + i), vt), load(cb + i));
+			r = add(mul(r, vt), load(cc + i));
+			r = add(mul(r, vt), load(cd + i));
+			store(out + i, r);
+		}
+	}
+}
+
+void normalizeQuat(Staging& s)
+{
+	float* x = s.plane(Staging::kOutputPlane + 0);
+	float* y = s.plane(Staging::kOutputPlane + 1);
+	float* z = s.plane(Staging::kOutputPlane + 2);
+	float* w = s.plane(Staging::kOutputPlane + 3);
+	for (std::size_t i = 0; i < s.stride; i += kBatchWidth) {
+		Batch vx = load(x + i), vy = load(y + i), vz = load(z + i), vw = load(w + i);
+		Batch lengthSq = add(add(mul(vx, vx), mul(vy, vy)), add(mul(vz, vz), mul(vw, vw)));
+		Batch invLength = div(set1(1.0f), sqrt(lengthSq));
+		store(x + i, mul(vx, invLength));
+		store(y + i, mul(vy, invLength));
+		store(z + i, mul(vz, invLength));
+		store(w + i, mul(vw, invLength));
+	}
+}
+
+void scatter(Staging const& s, TargetPath path, std::vector<int> const& targetNodes, Pose& pose)
+{
+	float const* out[4] = {s.plane(Staging::kOutputPlane), s.plane(Staging::kOutputPlane + 1), s.plane(Staging::kOutputPlane + 2),
+												 s.plane(Staging::kOutputPlane + 3)};
+
+	for (std::size_t i = 0; i < targetNodes.size(); ++i) {
+		int targetNode = targetNodes[i];
+		if (targetNode < 0 || static_cast<std::size_t>(targetNode) >= pose.nodeCount)
+			continue; // Skip invalid target nodes
+
+		switch (path) {
+		case TargetPath::ROTATION:
+			pose.setRotation(targetNode, glm::quat(out[3][i], out[0][i], out[1][i], out[2][i]));
+			break;
+		case TargetPath::TRANSLATION:
+			pose.setTranslation(targetNode, glm::vec3(out[0][i], out[1][i], out[2][i]));
+			break;
+		case TargetPath::SCALE:
+			pose.setScale(targetNode, glm::vec3(out[0][i], out[1][i], out[2][i]));
+			break;
+		}
+	}
+}
+
+void blendPoses(Pose const& from, Pose const& to, float weight, Pose& out)
+{
+	std::size_t nodeCount = std::min({from.nodeCount, to.nodeCount, out.nodeCount});
+	if (nodeCount == 0)
+		return;
+
+	// One lane per node through the same staging planes as the clips, so the blend runs on the lerp and normalize kernels
+	Staging& s = threadStaging();
+	s.reserve(nodeCount);
+	std::fill_n(s.plane(Staging::kFactorPlane), nodeCount, weight);
+
+	for (std::size_t i = 0; i < nodeCount; ++i) {
+		glm::quat a = from.rotations[i];
+		glm::quat b = to.rotations[i];
+		if (glm::dot(a, b) < 0.0f)
+			b = -b; // Same hemisphere as the source
+		float const ac[4] = {a.x, a.y, a.z, a.w};
+		float const bc[4] = {b.x, b.y, b.z, b.w};
+		for (int c = 0; c < 4; ++c) {
+			s.plane(c)[i] = ac[c];
+			s.plane(4 + c)[i] = bc[c];
+		}
+	}
+	s.padLanes(nodeCount);
+	lerp(s, 4);
+	normalizeQuat(s);
+
+	float const* o[4] = {s.plane(Staging::kOutputPlane), s.plane(Staging::kOutputPlane + 1), s.plane(Staging::kOutputPlane + 2),
+											 s.plane(Staging::kOutputPlane + 3)};
+	for (std::size_t i = 0; i < nodeCount; ++i)
+		out.setRotation(i, glm::quat(o[3][i], o[0][i], o[1][i], o[2][i]));
+
+	// Translations and scales share the three component planes, one pass each
+	for (TargetPath path : {TargetPath::TRANSLATION, TargetPath::SCALE}) {
+		glm::vec3 const* a = path == TargetPath::TRANSLATION ? from.translations : from.scales;
+		glm::vec3 const* b = path == TargetPath::TRANSLATION ? to.translations : to.scales;
+		for (std::size_t i = 0; i < nodeCount; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				s.plane(c)[i] = a[i][c];
+				s.plane(4 + c)[i] = b[i][c];
+			}
+		}
+		lerp(s, 3);
+
+		for (std::size_t i = 0; i < nodeCount; ++i) {
+			glm::vec3 v(o[0][i], o[1][i], o[2][i]);
+			if (path == TargetPath::TRANSLATION)
+				out.setTranslation(i, v);
+			else
+				out.setScale(i, v);
+		}
+	}
+}
+
+void skinPositions(Vertex const* vertices, std::size_t begin, std::size_t end, glm::mat4 const* jointMatrices, std::size_t jointCount, glm::vec3* out)
+{
+	int ids[4];
+	float weights[4];
+	std::size_t i = begin;
+
+#if defined(__AVX__)
+	// Pairs of skinned vertices share each multiply, a vertex without joints drops back to the single path
+	int idsB[4];
+	float weightsB[4];
+	for (; i + 1 < end; i += 2) {
+		bool skinnedA = skinWeights(vertices[i], jointCount, ids, weights);
+		bool skinnedB = skinWeights(vertices[i + 1], jointCount, idsB, weightsB);
+		if (!skinnedA || !skinnedB) {
+			out[i] = vertices[i].position;
+			out[i + 1] = vertices[i + 1].position;
+			if (skinnedA)
+				storePosition(out[i], skinVertex(vertices[i], jointMatrices, ids, weights));
+			if (skinnedB)
+				storePosition(out[i + 1], skinVertex(vertices[i + 1], jointMatrices, idsB, weightsB));
+			continue;
+		}
+
+		__m256 p = skinVertexPair(vertices[i], vertices[i + 1], jointMatrices, ids, weights, idsB, weightsB);
+		storePosition(out[i], _mm256_castps256_ps128(p));
+		storePosition(out[i + 1], _mm256_extractf128_ps(p, 1));
+	}
+#endif
+
+	for (; i < end; ++i) {
+		Vertex const& v = vertices[i];
+		if (!skinWeights(v, jointCount, ids, weights)) {
+			out[i] = v.position;
+			continue;
+		}
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+		storePosition(out[i], skinVertex(v, jointMatrices, ids, weights));
+#else
+		glm::mat4 blended = jointMatrices[ids[0]] * weights[0] + jointMatrices[ids[1]] * weights[1] + jointMatrices[ids[2]] * weights[2] +
+												jointMatrices[ids[3]] * weights[3];
+		out[i] = glm::vec3(blended * glm::vec4(v.position, 1.0f));
+#endif
+	}
+}
+
+} // namespace AnimationKernels
@@ -0,0 +1,212 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "AnimationSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "AnimationInstance.hpp"
+#include "ClipResidency.hpp"
+#include "GameObject.hpp"
+#include "GlobalAnimationState.hpp"
+#include "Model.hpp"
+#include "Scene.hpp"
+
+namespace {
+
+double nowMs() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+} // namespace
+
+AnimationSystem::AnimationSystem()
+{
+	// The main thread works through the jobs as well, so one core is left to it
+	unsigned int cores = std::thread::hardware_concurrency();
+	std::size_t workerCount = cores > 1 ? cores - 1 : 0;
+	for (std::size_t i = 0; i < workerCount; ++i)
+		workers_.emplace_back(&AnimationSystem::workerLoop_, this);
+
+	// std::cout << "[AnimationSystem INFO] Started " << workerCount << " workers" << std::endl;
+}
+
+AnimationSystem::~AnimationSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	wake_.notify_all();
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+void AnimationSystem::dispatch(Scene& scene, float dt)
+{
+	if (dispatched_)
+		sync();
+
+	// No job is running, so decoded clips can be swapped in and idle ones dropped
+	ClipResidency::getInstance().update(dt);
+
+	dispatchTime_ = nowMs();
+	jobs_.clear();
+	tierCounts_.fill(0);
+	GlobalAnimationState const& state = GlobalAnimationState::getInstance();
+	int offscreenInterval = state.lodOffscreenInterval;
+
+	// Only the object the controls drive is exempt, other objects of the same model still drop to lower tiers
+	GameObject const* controlled = state.gameObjectName.empty() ? nullptr : scene.findGameObject(state.gameObjectName).get();
+
+	for (auto const& goPtr : scene.gameObjects) {
+		if (!goPtr || !goPtr->active || !goPtr->hasAnimation() || !goPtr->getAnimation()->isPlaying())
+			continue;
+
+		AnimationLOD tier = selectTier_(*goPtr, scene, controlled);
+		++tierCounts_[static_cast<std::size_t>(tier)];
+		if (tier == AnimationLOD::OFFSCREEN && offscreenInterval <= 0)
+			continue; // Paused while out of view
+
+		jobs_.push_back({goPtr.get(), goPtr->getAnimation().get(), tier});
+	}
+
+	dispatched_ = true;
+	if (jobs_.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobCount_ = jobs_.size();
+		dt_ = dt;
+		lodReducedInterval_ = GlobalAnimationState::getInstance().lodReducedInterval;
+		lodOffscreenInterval_ = offscreenInterval;
+		nextJob_.store(0, std::memory_order_relaxed);
+		pendingJobs_.store(jobs_.size(), std::memory_order_relaxed);
+		++generation_;
+	}
+
+	// A single job is not worth waking anyone for, sync() runs it
+	if (jobs_.size() > 1)
+		wake_.notify_all();
+}
+
+AnimationLOD AnimationSystem::selectTier_(GameObject const& gameObject, Scene const& scene, GameObject const* controlled)
+{
+	GlobalAnimationState const& state = GlobalAnimationState::getInstance();
+	if (!state.lodEnabled || &gameObject == controlled)
+		return AnimationLOD::FULL; // The controlled character always runs at full rate
+
+	// Last frame's camera, the box of a paused character is still where it was left
+	if (!BBoxUtil::isInsideFrustum(gameObject.worldBBox, scene.cam.proj * scene.cam.view))
+		return AnimationLOD::OFFSCREEN;
+
+	float distance = glm::length(BBoxUtil::getBBoxCenter(gameObject.worldBBox) - scene.cam.pos);
+	return distance > state.lodReducedDistance ? AnimationLOD::REDUCED : AnimationLOD::FULL;
+}
+
+void AnimationSystem::runJobs_()
+{
+	for (;;) {
+		std::size_t index = nextJob_.fetch_add(1, std::memory_order_relaxed);
+		if (index >= jobCount_)
+			return;
+
+		if (task_) {
+			(*task_)(index);
+		}
+		else {
+			Job const& job = jobs_[index];
+			switch (job.tier) {
+			case AnimationLOD::REDUCED:
+				job.animation->advanceReduced(dt_, lodReducedInterval_, true);
+				break;
+			case AnimationLOD::OFFSCREEN:
+				job.animation->advanceReduced(dt_, lodOffscreenInterval_, false);
+				break;
+			default:
+				job.animation->advance(dt_);
+				break;
+			}
+		}
+
+		if (pendingJobs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			done_.notify_all();
+		}
+	}
+}
+
+void AnimationSystem::workerLoop_()
+{
+	std::size_t seenGeneration = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&] { return quit_ || generation_ != seenGeneration; });
+			if (quit_)
+				return;
+			seenGeneration = generation_;
+			if (pendingJobs_.load(std::memory_order_acquire) == 0)
+				continue; // Woke after the frame was finished, the job list may already be rebuilt for the next one
+			++activeWorkers_;
+		}
+		runJobs_();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			--activeWorkers_;
+		}
+		done_.notify_all();
+	}
+}
+
+void AnimationSystem::sync()
+{
+	if (!dispatched_)
+		return;
+	dispatched_ = false;
+
+	stats_ = PoseUpdateStats{};
+	if (!jobs_.empty()) {
+		runJobs_();
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		// Workers that woke late still have to leave runJobs_ before the job list is touched again
+		done_.wait(lock, [&] { return pendingJobs_.load(std::memory_order_acquire) == 0 && activeWorkers_ == 0; });
+	}
+
+	// Back on the main thread, the world boxes follow the poses that moved
+	for (Job const& job : jobs_) {
+		PoseUpdateStats const& update = job.animation->getLastUpdate();
+		stats_ += update;
+		if (update.changed())
+			job.gameObject->updateTransformMatrix();
+	}
+
+	lastUpdateMs_ = nowMs() - dispatchTime_;
+}
+
+void AnimationSystem::parallelFor(std::size_t count, std::function<void(std::size_t)> const& task)
+{
+	if (dispatched_)
+		sync();
+	if (count == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		task_ = &task;
+		jobCount_ = count;
+		nextJob_.store(0, std::memory_order_relaxed);
+		pendingJobs_.store(count, std::memory_order_relaxed);
+		++generation_;
+	}
+	if (count > 1)
+		wake_.notify_all();
+
+	runJobs_();
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		done_.wait(lock, [&] { return pendingJobs_.load(std::memory_order_acquire) == 0 && activeWorkers_ == 0; });
+		task_ = nullptr;
+	}
+}
@@ -9,6 +9,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "AnimationClip.hpp"
+#include "AnimationInstance.hpp"
 #include "Collider.hpp"
 #include "CollisionSystem.hpp"
 #include "DialogSystem.hpp"
@@ -264,18 +265,13 @@ void Application::processInput_(float dt)
                     }
 
 
-					if (isMoving && !animStateRef.wasMoving) { // Started moving
-						animStateRef.clipIndex = walkAnimIndex;
-						animStateRef.play(animStateRef.clipIndex, 0.0f);
-					} else if (!isMoving && animStateRef.wasMoving) { // Stopped moving
-						animStateRef.stop();
-                        animStateRef.clipIndex = idleAnimIndex; // Switch to idle animation clip
-                        // Reset idle animation to its start if you want it to always restart
-                        // This might conflict with DialogSystem's idle animation handling if not careful
-                        if(gameObject.getModel()->animations[animStateRef.clipIndex]) {
-						    gameObject.getModel()->animations[animStateRef.clipIndex]->setAnimationFrame(gameObject.getModel()->nodes, 0.0f);
-						    gameObject.getModel()->updateLocalMatrices();
-                        }
+					AnimationInstance* anim = gameObject.getAnimation().get();
+					if (anim && isMoving && !animStateRef.wasMoving) { // Started moving
+						anim->crossfade(walkAnimIndex, animStateRef.crossfadeDuration);
+					} else if (anim && !isMoving && animStateRef.wasMoving) { // Stopped moving
+						// Blend into the idle loop, the AnimationSystem runs the fade
+						anim->crossfade(idleAnimIndex, animStateRef.crossfadeDuration);
+						gameObject.updateTransformMatrix();
 					}
 				}
 				animStateRef.wasMoving = isMoving;
@@ -284,31 +280,6 @@ void Application::processInput_(float dt)
 			sceneRef.cam.processKeyboard(dt, window_);
 		}
 	}
-
-	// Update player animation if moving and animation is playing
-	if (animStateRef.isAnimating && animStateRef.wasMoving && charMode && !animStateRef.gameObjectName.empty()) {
-		auto goSharedPtr = sceneRef.findGameObject(animStateRef.gameObjectName);
-		if (goSharedPtr && goSharedPtr->hasModel() && !goSharedPtr->getModel()->animations.empty()) {
-			GameObject& gameObject = *goSharedPtr;
-			int currentClipIdx = animStateRef.clipIndex;
-
-			if (currentClipIdx >= 0 && static_cast<size_t>(currentClipIdx) < gameObject.getModel()->animations.size() && gameObject.getModel()->animations[currentClipIdx]) {
-				auto& animClip = gameObject.getModel()->animations[currentClipIdx];
-				animStateRef.currentTime += dt * animStateRef.getAnimateSpeed();
-				float duration = animClip->getDuration();
-				if (duration > 0.0f) {
-					animStateRef.currentTime = std::fmod(animStateRef.currentTime, duration);
-				} else {
-					animStateRef.currentTime = 0.0f;
-				}
-				animClip->setAnimationFrame(gameObject.getModel()->nodes, animStateRef.currentTime);
-				gameObject.getModel()->updateLocalMatrices(); // Ensure model matrices are updated after animation
-			} else {
-                 // std::cerr << "Player animation: Invalid clip index " << currentClipIdx << std::endl;
-                 animStateRef.stop();
-            }
-		}
-	}
 }
 
 
@@ -316,12 +287,16 @@ void Application::tick_(float dt)
 {
 	processInput_(dt); // Handles player movement, animation state, and camera free-move
 
-	dialogSysRef.update(sceneRef, dt); // Handles NPC logic, idle animations, interaction checks
+	dialogSysRef.update(sceneRef);			// Handles NPC logic, idle animations, interaction checks
 	dialogSysRef.processInput(window_); // Handles player input for dialog progression
 
+	animationSysRef.dispatch(sceneRef, dt); // Advances the player's and the NPCs' animation instances on the worker pool
+
 	// Other game logic updates can go here
 	// For example, physics updates for all dynamic objects, AI updates not handled by DialogSystem etc.
+	// Playback must not be changed until the animation sync below
 
+	animationSysRef.sync();	 // Poses and world boxes are final from here on
 	collisionSysRef.update(); // Handles collision detection and resolution
 
 	// Update camera follow if in character mode
@@ -0,0 +1,153 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "BakedClip.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "AnimationClip.hpp"
+#include "PosePool.hpp"
+
+namespace {
+
+// Scratch pose covering every node index a clip targets
+PooledPose makeScratchPose(std::vector<int> const& rotationNodes, std::vector<int> const& translationNodes, std::vector<int> const& scaleNodes)
+{
+	int maxNode = -1;
+	for (auto const* targets : {&rotationNodes, &translationNodes, &scaleNodes}) {
+		if (!targets->empty())
+			maxNode = std::max(maxNode, targets->back());
+	}
+	return PooledPose(static_cast<std::size_t>(maxNode + 1), 0);
+}
+
+glm::quat nlerp(glm::quat const& a, glm::quat const& b, float t) { return glm::normalize(a * (1.0f - t) + b * t); }
+
+} // namespace
+
+void BakedClip::clear()
+{
+	frameRate_ = 0.0f;
+	duration_ = 0.0f;
+	frameCount_ = 0;
+	rotationNodes_.clear();
+	translationNodes_.clear();
+	scaleNodes_.clear();
+	rotations_.clear();
+	translations_.clear();
+	scales_.clear();
+	report_ = BakeReport{};
+}
+
+void BakedClip::bake(AnimationClip const& source, float sampleRate)
+{
+	clear();
+	float const duration = source.getDuration();
+	if (duration <= 0.0f || sampleRate <= 0.0f)
+		return;
+
+	rotationNodes_ = source.getTargetNodes(TargetPath::ROTATION);
+	translationNodes_ = source.getTargetNodes(TargetPath::TRANSLATION);
+	scaleNodes_ = source.getTargetNodes(TargetPath::SCALE);
+
+	// Round the frame count up so the requested rate is a lower bound, the last frame lands exactly on the clip's end
+	std::size_t intervals = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(duration * sampleRate)));
+	frameCount_ = intervals + 1;
+	frameRate_ = static_cast<float>(intervals) / duration;
+	duration_ = duration;
+
+	rotations_.reserve(frameCount_ * rotationNodes_.size());
+	translations_.reserve(frameCount_ * translationNodes_.size());
+	scales_.reserve(frameCount_ * scaleNodes_.size());
+
+	PooledPose scratch = makeScratchPose(rotationNodes_, translationNodes_, scaleNodes_);
+	Pose& pose = scratch.get();
+	std::vector<std::size_t> cursors(source.getChannelCount(), 0);
+
+	for (std::size_t frame = 0; frame < frameCount_; ++frame) {
+		float time = std::min(static_cast<float>(frame) / frameRate_, duration_);
+		source.evaluateKeyframes(pose, time, cursors.data());
+
+		for (std::size_t i = 0; i < rotationNodes_.size(); ++i) {
+			glm::quat q = pose.rotations[rotationNodes_[i]];
+
+			// Keep consecutive frames on the same hemisphere so sampling can blend them directly
+			if (frame > 0 && glm::dot(rotations_[(frame - 1) * rotationNodes_.size() + i], q) < 0.0f)
+				q = -q;
+			rotations_.push_back(q);
+		}
+		for (int node : translationNodes_)
+			translations_.push_back(pose.translations[node]);
+		for (int node : scaleNodes_)
+			scales_.push_back(pose.scales[node]);
+	}
+
+	report_.sampleRate = sampleRate;
+	report_.frameCount = frameCount_;
+	report_.bytes = rotations_.size() * sizeof(glm::quat) + (translations_.size() + scales_.size()) * sizeof(glm::vec3);
+	measureError_(source);
+
+	// std::cout << "[BakedClip INFO] Baked " << frameCount_ << " frames, " << report_.bytes << " bytes, max rotation error " << report_.maxRotationError
+	// << " rad" << std::endl;
+}
+
+void BakedClip::measureError_(AnimationClip const& source)
+{
+	// The baked curve matches the source on every frame, so compare inside each interval
+	PooledPose reference = makeScratchPose(rotationNodes_, translationNodes_, scaleNodes_);
+	PooledPose baked = makeScratchPose(rotationNodes_, translationNodes_, scaleNodes_);
+	std::vector<std::size_t> cursors(source.getChannelCount(), 0);
+
+	for (std::size_t frame = 0; frame + 1 < frameCount_; ++frame) {
+		for (float offset : {0.25f, 0.5f, 0.75f}) {
+			float time = std::min((static_cast<float>(frame) + offset) / frameRate_, duration_);
+			source.evaluateKeyframes(reference.get(), time, cursors.data());
+			sample(baked.get(), time);
+
+			Pose const& r = reference.get();
+			Pose const& b = baked.get();
+			for (int node : rotationNodes_) {
+				float d = std::min(1.0f, std::abs(glm::dot(r.rotations[node], b.rotations[node])));
+				report_.maxRotationError = std::max(report_.maxRotationError, 2.0f * std::acos(d));
+			}
+			for (int node : translationNodes_)
+				report_.maxTranslationError = std::max(report_.maxTranslationError, glm::length(r.translations[node] - b.translations[node]));
+			for (int node : scaleNodes_)
+				report_.maxScaleError = std::max(report_.maxScaleError, glm::length(r.scales[node] - b.scales[node]));
+		}
+	}
+}
+
+void BakedClip::sample(Pose& pose, float time) const
+{
+	if (frameCount_ == 0)
+		return;
+
+	// Two table rows and a blend factor
+	float position = std::clamp(time, 0.0f, duration_) * frameRate_;
+	std::size_t frame0 = std::min(static_cast<std::size_t>(position), frameCount_ - 1);
+	std::size_t frame1 = std::min(frame0 + 1, frameCount_ - 1);
+	float alpha = position - static_cast<float>(frame0);
+
+	glm::quat const* rotations0 = rotations_.data() + frame0 * rotationNodes_.size();
+	glm::quat const* rotations1 = rotations_.data() + frame1 * rotationNodes_.size();
+	for (std::size_t i = 0; i < rotationNodes_.size(); ++i) {
+		if (static_cast<std::size_t>(rotationNodes_[i]) < pose.nodeCount)
+			pose.setRotation(rotationNodes_[i], nlerp(rotations0[i], rotations1[i], alpha));
+	}
+
+	glm::vec3 const* translations0 = translations_.data() + frame0 * translationNodes_.size();
+	glm::vec3 const* translations1 = translations_.data() + frame1 * translationNodes_.size();
+	for (std::size_t i = 0; i < translationNodes_.size(); ++i) {
+		if (static_cast<std::size_t>(translationNodes_[i]) < pose.nodeCount)
+			pose.setTranslation(translationNodes_[i], glm::mix(translations0[i], translations1[i], alpha));
+	}
+
+	glm::vec3 const* scales0 = scales_.data() + frame0 * scaleNodes_.size();
+	glm::vec3 const* scales1 = scales_.data() + frame1 * scaleNodes_.size();
+	for (std::size_t i = 0; i < scaleNodes_.size(); ++i) {
+		if (static_cast<std::size_t>(scaleNodes_[i]) < pose.nodeCount)
+			pose.setScale(scaleNodes_[i], glm::mix(scales0[i], scales1[i], alpha));
+	}
+}
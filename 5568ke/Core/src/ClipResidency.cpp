@@ -0,0 +1,117 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "ClipResidency.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "AnimationClip.hpp"
+#include "GlobalAnimationState.hpp"
+
+ClipResidency::ClipResidency() : loader_(&ClipResidency::loaderLoop_, this) {}
+
+ClipResidency::~ClipResidency()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	wake_.notify_all();
+	loader_.join();
+}
+
+void ClipResidency::track(std::shared_ptr<AnimationClip> const& clip) { tracked_.push_back(clip); }
+
+void ClipResidency::request(std::shared_ptr<AnimationClip> clip)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_.push_back(std::move(clip));
+	}
+	wake_.notify_one();
+}
+
+void ClipResidency::loaderLoop_()
+{
+	for (;;) {
+		std::shared_ptr<AnimationClip> clip;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&] { return quit_ || !queue_.empty(); });
+			if (quit_)
+				return;
+			clip = std::move(queue_.front());
+			queue_.pop_front();
+		}
+
+		// Decoding only reads the clip's source, the clip itself keeps being sampled (as not resident) meanwhile
+		std::shared_ptr<AnimationClip> decoded = clip->decode_();
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		finished_.emplace_back(std::move(clip), std::move(decoded));
+	}
+}
+
+void ClipResidency::update(float dt)
+{
+	clock_ += dt;
+
+	// Install what the loader finished since the last frame
+	std::vector<std::pair<std::shared_ptr<AnimationClip>, std::shared_ptr<AnimationClip>>> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		finished.swap(finished_);
+	}
+	for (auto& [clip, decoded] : finished) {
+		clip->install_(*decoded);
+		clip->lastUsed_.store(clock_, std::memory_order_relaxed);
+		++stats_.decodes;
+		// std::cout << "[ClipResidency INFO] Decoded '" << clip->clipName << "', " << clip->getMemoryBytes() << " bytes" << std::endl;
+	}
+
+	evict_();
+}
+
+void ClipResidency::evict_()
+{
+	// Forget clips whose models are gone
+	tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(), [](std::weak_ptr<AnimationClip> const& clip) { return clip.expired(); }),
+								 tracked_.end());
+
+	ClipResidencyStats stats;
+	stats.decodes = stats_.decodes;
+	stats.evictions = stats_.evictions;
+	stats.trackedClips = tracked_.size();
+
+	std::vector<std::shared_ptr<AnimationClip>> resident;
+	for (auto const& weak : tracked_) {
+		auto clip = weak.lock();
+		stats.sourceBytes += clip->getSourceBytes();
+		if (clip->getResidency() == ClipResidencyState::DECODING)
+			++stats.decodingClips;
+		else if (clip->isResident()) {
+			resident.push_back(clip);
+			stats.residentBytes += clip->getMemoryBytes();
+		}
+	}
+
+	// Least recently used first, only clips idle for longer than the configured time are candidates
+	GlobalAnimationState const& animState = GlobalAnimationState::getInstance();
+	std::size_t budget = static_cast<std::size_t>(animState.clipMemoryBudgetKB) * 1024;
+	if (stats.residentBytes > budget) {
+		std::sort(resident.begin(), resident.end(), [](auto const& a, auto const& b) { return a->getLastUsed() < b->getLastUsed(); });
+		for (auto const& clip : resident) {
+			if (stats.residentBytes <= budget || clock_ - clip->getLastUsed() < animState.clipEvictSeconds)
+				break;
+
+			stats.residentBytes -= clip->getMemoryBytes();
+			clip->evict_();
+			++stats.evictions;
+			// std::cout << "[ClipResidency INFO] Evicted '" << clip->clipName << "'" << std::endl;
+		}
+	}
+
+	for (auto const& clip : resident)
+		stats.residentClips += clip->isResident() ? 1 : 0;
+	stats_ = stats;
+}
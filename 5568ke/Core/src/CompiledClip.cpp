@@ -0,0 +1,290 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "CompiledClip.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "AnimationChannel.hpp"
+#include "AnimationKernels.hpp"
+#include "PosePool.hpp"
+
+namespace {
+
+glm::quat nlerp(glm::quat const& a, glm::quat const& b, float t) { return glm::normalize(a * (1.0f - t) + b * t); }
+
+float angleBetween(glm::quat const& a, glm::quat const& b)
+{
+	float d = std::min(1.0f, std::abs(glm::dot(a, b)));
+	return 2.0f * std::acos(d);
+}
+
+} // namespace
+
+void CompiledClip::clear()
+{
+	groups_.clear();
+	channelCount_ = 0;
+	compiled_ = false;
+}
+
+void CompiledClip::compile(std::vector<std::shared_ptr<AnimationChannel>> const& channels)
+{
+	clear();
+	channelCount_ = channels.size();
+
+	for (std::size_t i = 0; i < channels.size(); ++i) {
+		if (channels[i] && channels[i]->targetNode >= 0)
+			addTrack_(*channels[i], static_cast<std::uint32_t>(i));
+	}
+
+	compiled_ = true;
+	// std::cout << "[CompiledClip INFO] Compiled " << getTrackCount() << " tracks into " << groups_.size() << " groups" << std::endl;
+}
+
+std::size_t CompiledClip::getTrackCount() const
+{
+	std::size_t count = 0;
+	for (auto const& group : groups_)
+		count += group.targetNodes.size();
+	return count;
+}
+
+std::size_t CompiledClip::getMemoryBytes() const
+{
+	std::size_t bytes = sizeof(*this);
+	for (auto const& group : groups_) {
+		bytes += sizeof(TrackGroup);
+		bytes += group.targetNodes.size() * sizeof(int) + (group.channelIndices.size() + group.keyOffsets.size()) * sizeof(std::uint32_t);
+		bytes += group.times.size() * sizeof(float);
+		for (int c = 0; c < 4; ++c) {
+			bytes += group.values[c].size() * sizeof(float);
+			for (int k = 0; k < 4; ++k)
+				bytes += group.coefficients[k][c].size() * sizeof(float);
+		}
+	}
+	return bytes;
+}
+
+std::vector<int> CompiledClip::getTargetNodes(TargetPath path) const
+{
+	std::vector<int> targets;
+	for (auto const& group : groups_) {
+		if (group.path == path)
+			targets.insert(targets.end(), group.targetNodes.begin(), group.targetNodes.end());
+	}
+
+	std::sort(targets.begin(), targets.end());
+	targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+	return targets;
+}
+
+CompiledClip::TrackGroup& CompiledClip::groupFor_(TargetPath path, Kernel kernel)
+{
+	for (auto& group : groups_) {
+		if (group.path == path && group.kernel == kernel)
+			return group;
+	}
+
+	TrackGroup& group = groups_.emplace_back();
+	group.path = path;
+	group.kernel = kernel;
+	group.componentCount = path == TargetPath::ROTATION ? 4 : 3;
+	group.keyOffsets.push_back(0);
+	return group;
+}
+
+void CompiledClip::addTrack_(AnimationChannel const& channel, std::uint32_t channelIndex)
+{
+	std::vector<float> const& timings = channel.getTimings();
+	InterpolationType interpolation = channel.getInterpolationType();
+	std::size_t const keyCount = timings.size();
+	std::size_t const valuesPerKey = interpolation == InterpolationType::CUBICSPLINE ? 3 : 1;
+
+	// Flatten the channel's values to (x, y, z, w) keyframes, the quaternion layout matches glm::quat's members
+	std::vector<glm::vec4> keys;
+	switch (channel.targetPath) {
+	case TargetPath::ROTATION:
+		for (auto const& q : channel.getRotations())
+			keys.emplace_back(q.x, q.y, q.z, q.w);
+		break;
+	case TargetPath::TRANSLATION:
+		for (auto const& v : channel.getTranslations())
+			keys.emplace_back(v, 0.0f);
+		break;
+	case TargetPath::SCALE:
+		for (auto const& v : channel.getScalings())
+			keys.emplace_back(v, 0.0f);
+		break;
+	}
+
+	if (keyCount == 0 || keys.size() != keyCount * valuesPerKey) {
+		// std::cout << "[CompiledClip WARNING] Skipping channel " << channelIndex << " with mismatched keyframe data" << std::endl;
+		return;
+	}
+
+	// Cubic spline values are (in-tangent, value, out-tangent) triples
+	auto value = [&](std::size_t key) { return keys[key * valuesPerKey + (valuesPerKey == 3 ? 1 : 0)]; };
+
+	// Pick the kernel, a single keyframe is constant whatever the interpolation
+	Kernel kernel = Kernel::STEP;
+	if (keyCount > 1 && interpolation == InterpolationType::LINEAR)
+		kernel = channel.targetPath == TargetPath::ROTATION ? Kernel::NLERP : Kernel::LERP;
+	else if (keyCount > 1 && interpolation == InterpolationType::CUBICSPLINE)
+		kernel = Kernel::HERMITE;
+
+	// Align LINEAR rotations to the shortest arc once, then check how far nlerp strays from slerp on the worst segment
+	if (kernel == Kernel::NLERP) {
+		for (std::size_t k = 1; k < keyCount; ++k) {
+			if (glm::dot(keys[k - 1], keys[k]) < 0.0f)
+				keys[k] = -keys[k];
+		}
+
+		float maxError = 0.0f;
+		for (std::size_t k = 0; k + 1 < keyCount && maxError <= kNlerpTolerance; ++k) {
+			glm::quat q0(keys[k].w, keys[k].x, keys[k].y, keys[k].z);
+			glm::quat q1(keys[k + 1].w, keys[k + 1].x, keys[k + 1].y, keys[k + 1].z);
+			for (int step = 1; step < 8; ++step) {
+				float t = static_cast<float>(step) / 8.0f;
+				maxError = std::max(maxError, angleBetween(nlerp(q0, q1, t), glm::slerp(q0, q1, t)));
+			}
+		}
+
+		if (maxError > kNlerpTolerance)
+			kernel = Kernel::SLERP;
+	}
+
+	TrackGroup& group = groupFor_(channel.targetPath, kernel);
+	group.targetNodes.push_back(channel.targetNode);
+	group.channelIndices.push_back(channelIndex);
+	group.times.insert(group.times.end(), timings.begin(), timings.end());
+	group.keyOffsets.push_back(static_cast<std::uint32_t>(group.times.size()));
+
+	if (kernel != Kernel::HERMITE) {
+		for (std::size_t k = 0; k < keyCount; ++k) {
+			glm::vec4 v = value(k);
+			for (int c = 0; c < group.componentCount; ++c)
+				group.values[c].push_back(v[c]);
+		}
+		return;
+	}
+
+	// Hermite basis folded into per-segment polynomial coefficients, tangents are scaled by the segment duration
+	for (std::size_t k = 0; k + 1 < keyCount; ++k) {
+		float dt = timings[k + 1] - timings[k];
+		glm::vec4 p0 = keys[k * 3 + 1];
+		glm::vec4 m0 = dt * keys[k * 3 + 2];
+		glm::vec4 p1 = keys[(k + 1) * 3 + 1];
+		glm::vec4 m1 = dt * keys[(k + 1) * 3];
+
+		glm::vec4 a = 2.0f * p0 + m0 - 2.0f * p1 + m1;
+		glm::vec4 b = -3.0f * p0 - 2.0f * m0 + 3.0f * p1 - m1;
+		for (int c = 0; c < group.componentCount; ++c) {
+			group.coefficients[0][c].push_back(a[c]);
+			group.coefficients[1][c].push_back(b[c]);
+			group.coefficients[2][c].push_back(m0[c]);
+			group.coefficients[3][c].push_back(p0[c]);
+		}
+	}
+}
+
+void CompiledClip::evaluate(Pose& pose, float time, std::size_t* cursors) const
+{
+	for (auto const& group : groups_)
+		evaluateGroup_(group, pose, time, cursors);
+}
+
+void CompiledClip::evaluateGroup_(TrackGroup const& group, Pose& pose, float time, std::size_t* cursors) const
+{
+	std::size_t const trackCount = group.targetNodes.size();
+	if (trackCount == 0)
+		return;
+
+	using AnimationKernels::Staging;
+	Staging& s = AnimationKernels::threadStaging();
+	s.reserve(trackCount);
+	float* t = s.plane(Staging::kFactorPlane);
+	float* out[4] = {s.plane(Staging::kOutputPlane), s.plane(Staging::kOutputPlane + 1), s.plane(Staging::kOutputPlane + 2), s.plane(Staging::kOutputPlane + 3)};
+
+	// Gather: locate each track's segment (scalar, cursor driven) and fill the SoA lanes
+	for (std::size_t i = 0; i < trackCount; ++i) {
+		std::uint32_t const offset = group.keyOffsets[i];
+		std::size_t const keyCount = group.keyOffsets[i + 1] - offset;
+		float const* times = group.times.data() + offset;
+
+		std::size_t segment = 0;
+		float factor = 0.0f;
+		if (keyCount > 1 && time >= times[keyCount - 1]) {
+			segment = keyCount - 2;
+			factor = 1.0f;
+		}
+		else if (keyCount > 1 && time > times[0]) {
+			std::size_t freshCursor = 0;
+			std::size_t& cursor = cursors ? cursors[group.channelIndices[i]] : freshCursor;
+			segment = AnimationKernels::findKeyframe(times, keyCount, time, cursor);
+			factor = (time - times[segment]) / (times[segment + 1] - times[segment]);
+		}
+		t[i] = factor;
+
+		switch (group.kernel) {
+		case Kernel::STEP: {
+			std::size_t key = factor >= 1.0f ? keyCount - 1 : segment;
+			for (int c = 0; c < group.componentCount; ++c)
+				out[c][i] = group.values[c][offset + key];
+			break;
+		}
+		case Kernel::LERP:
+		case Kernel::NLERP:
+			for (int c = 0; c < group.componentCount; ++c) {
+				s.plane(c)[i] = group.values[c][offset + segment];
+				s.plane(4 + c)[i] = group.values[c][offset + segment + 1];
+			}
+			break;
+		case Kernel::SLERP: {
+			auto key = [&](std::size_t k) { return glm::quat(group.values[3][k], group.values[0][k], group.values[1][k], group.values[2][k]); };
+			glm::quat q = glm::slerp(key(offset + segment), key(offset + segment + 1), factor);
+			out[0][i] = q.x;
+			out[1][i] = q.y;
+			out[2][i] = q.z;
+			out[3][i] = q.w;
+			break;
+		}
+		case Kernel::HERMITE: {
+			std::size_t first = offset - i;
+			for (int k = 0; k < 4; ++k) {
+				for (int c = 0; c < group.componentCount; ++c)
+					s.plane(k * 4 + c)[i] = group.coefficients[k][c][first + segment];
+			}
+			break;
+		}
+		}
+	}
+
+	s.padLanes(trackCount);
+
+	// Batched evaluation
+	switch (group.kernel) {
+	case Kernel::LERP:
+		AnimationKernels::lerp(s, group.componentCount);
+		break;
+	case Kernel::NLERP:
+		AnimationKernels::lerp(s, 4);
+		AnimationKernels::normalizeQuat(s);
+		break;
+	case Kernel::HERMITE:
+		AnimationKernels::hermite(s, group.componentCount);
+		if (group.path == TargetPath::ROTATION)
+			AnimationKernels::normalizeQuat(s);
+		break;
+	case Kernel::STEP:
+	case Kernel::SLERP:
+		break;
+	}
+
+	// Scatter into the pose's TRS
+	AnimationKernels::scatter(s, group.path, group.targetNodes, pose);
+}
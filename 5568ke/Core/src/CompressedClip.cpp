@@ -0,0 +1,525 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "CompressedClip.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "AnimationChannel.hpp"
+#include "AnimationKernels.hpp"
+#include "Node.hpp"
+#include "PosePool.hpp"
+
+namespace {
+
+constexpr float kQuatComponentRange = 0.70710678f; // The three smallest components of a unit quaternion lie in [-1/sqrt(2), 1/sqrt(2)]
+constexpr float kMaxQuantized = 65535.0f;
+constexpr int kCubicSubdivisions = 16; // Samples per cubic spline segment when resampling to linear
+
+/**
+ * @brief Error budget of one joint. Rotation and scale errors are multiplied by the distance to the farthest descendant,
+ * translation errors by the accumulated scale of the parent.
+ */
+struct JointBudget {
+	float rotation{};		 // radians
+	float translation{}; // local units
+	float scale{};
+};
+
+// Splits 'tolerance' over each root-to-leaf chain and over the animated paths of every joint on it, so that errors summed
+// along a chain stay within it at the chain's end
+std::vector<JointBudget> computeJointBudgets(std::vector<std::shared_ptr<Node>> const& nodes, std::vector<int> const& pathCounts, float tolerance)
+{
+	std::size_t const count = nodes.size();
+	std::vector<int> parents(count, -1);
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!nodes[i])
+			continue;
+		for (auto const& child : nodes[i]->children) {
+			if (child && child->nodeNum >= 0 && static_cast<std::size_t>(child->nodeNum) < count)
+				parents[child->nodeNum] = static_cast<int>(i);
+		}
+	}
+
+	// Bind pose globals, depth from the root and height of the subtree below every node
+	std::vector<glm::mat4> globals(count, glm::mat4(1.0f));
+	std::vector<int> depths(count, 0);
+	std::vector<int> heights(count, 0);
+	std::vector<bool> visited(count, false);
+	auto resolve = [&](auto&& self, std::size_t i) -> void {
+		if (visited[i])
+			return;
+		visited[i] = true;
+
+		glm::mat4 local(1.0f);
+		if (nodes[i])
+			local = glm::translate(glm::mat4(1.0f), nodes[i]->translation) * glm::mat4_cast(nodes[i]->rotation) * glm::scale(glm::mat4(1.0f), nodes[i]->scale);
+
+		if (parents[i] >= 0) {
+			self(self, parents[i]);
+			globals[i] = globals[parents[i]] * local;
+			depths[i] = depths[parents[i]] + 1;
+		}
+		else {
+			globals[i] = local;
+		}
+	};
+	for (std::size_t i = 0; i < count; ++i)
+		resolve(resolve, i);
+
+	// Walk every node up its ancestors to get each ancestor's subtree height and lever arm (reach of its farthest descendant)
+	std::vector<float> levers(count, 0.0f);
+	float reach = 0.0f;
+	for (std::size_t i = 0; i < count; ++i) {
+		glm::vec3 position(globals[i][3]);
+		int height = 1;
+		for (int p = parents[i]; p >= 0; p = parents[p], ++height) {
+			heights[p] = std::max(heights[p], height);
+			levers[p] = std::max(levers[p], glm::length(position - glm::vec3(globals[p][3])));
+			reach = std::max(reach, levers[p]);
+		}
+	}
+
+	std::vector<JointBudget> budgets(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		float share = tolerance / static_cast<float>((depths[i] + heights[i] + 1) * std::max(pathCounts[i], 1));
+		float parentScale = parents[i] >= 0 ? glm::length(glm::vec3(globals[parents[i]][0])) : 1.0f;
+
+		// Leaf joints still move the skin around them, give them at least the length of their own bone
+		float boneLength = nodes[i] ? glm::length(nodes[i]->translation) * parentScale : 0.0f;
+		float lever = std::max({levers[i], boneLength, 0.01f * reach, 1e-6f});
+
+		budgets[i].rotation = share / lever;
+		budgets[i].translation = share / std::max(parentScale, 1e-6f);
+		budgets[i].scale = share / lever;
+	}
+	return budgets;
+}
+
+/**
+ * @brief A channel resampled to (time, value) pairs at its source precision, rotations as (x, y, z, w).
+ *
+ */
+struct SampledTrack {
+	std::vector<float> times;
+	std::vector<glm::vec4> values;
+	bool step{false};
+};
+
+SampledTrack sampleChannel(AnimationChannel const& channel)
+{
+	SampledTrack track;
+	std::vector<float> const& timings = channel.getTimings();
+	InterpolationType interpolation = channel.getInterpolationType();
+	std::size_t const valuesPerKey = interpolation == InterpolationType::CUBICSPLINE ? 3 : 1;
+
+	std::vector<glm::vec4> raw;
+	switch (channel.targetPath) {
+	case TargetPath::ROTATION:
+		for (auto const& q : channel.getRotations())
+			raw.emplace_back(q.x, q.y, q.z, q.w);
+		break;
+	case TargetPath::TRANSLATION:
+		for (auto const& v : channel.getTranslations())
+			raw.emplace_back(v, 0.0f);
+		break;
+	case TargetPath::SCALE:
+		for (auto const& v : channel.getScalings())
+			raw.emplace_back(v, 0.0f);
+		break;
+	}
+
+	if (timings.empty() || raw.size() != timings.size() * valuesPerKey)
+		return track;
+
+	track.step = interpolation == InterpolationType::STEP;
+	if (interpolation != InterpolationType::CUBICSPLINE) {
+		track.times = timings;
+		track.values = raw;
+		return track;
+	}
+
+	// Cubic spline: keep every key value and add evenly spaced samples of the curve inside each segment
+	auto evaluate = [&](float time, std::size_t& cursor) {
+		switch (channel.targetPath) {
+		case TargetPath::ROTATION: {
+			glm::quat q = channel.getRotation(time, cursor);
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+		case TargetPath::TRANSLATION:
+			return glm::vec4(channel.getTranslation(time, cursor), 0.0f);
+		case TargetPath::SCALE:
+			return glm::vec4(channel.getScaling(time, cursor), 0.0f);
+		}
+		return glm::vec4(0.0f);
+	};
+
+	std::size_t cursor = 0;
+	for (std::size_t k = 0; k < timings.size(); ++k) {
+		track.times.push_back(timings[k]);
+		track.values.push_back(raw[k * 3 + 1]);
+
+		if (k + 1 == timings.size())
+			break;
+		for (int s = 1; s < kCubicSubdivisions; ++s) {
+			float time = timings[k] + (timings[k + 1] - timings[k]) * static_cast<float>(s) / kCubicSubdivisions;
+			track.times.push_back(time);
+			track.values.push_back(evaluate(time, cursor));
+		}
+	}
+	return track;
+}
+
+glm::quat toQuat(glm::vec4 const& v) { return glm::quat(v.w, v.x, v.y, v.z); }
+
+float rotationError(glm::quat const& a, glm::quat const& b)
+{
+	float d = std::min(1.0f, std::abs(glm::dot(a, b)));
+	return 2.0f * std::acos(d);
+}
+
+} // namespace
+
+void CompressedClip::packQuat(glm::quat const& q, std::uint16_t* packed)
+{
+	glm::quat unit = glm::normalize(q);
+	float components[4] = {unit.x, unit.y, unit.z, unit.w};
+
+	int largest = 0;
+	for (int i = 1; i < 4; ++i) {
+		if (std::abs(components[i]) > std::abs(components[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, flip so the dropped component is positive and can be rebuilt from the others
+	float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+	std::uint16_t quantized[3];
+	for (int i = 0, n = 0; i < 4; ++i) {
+		if (i == largest)
+			continue;
+		float normalized = std::clamp(components[i] * sign / kQuatComponentRange * 0.5f + 0.5f, 0.0f, 1.0f);
+		quantized[n++] = static_cast<std::uint16_t>(std::lround(normalized * 32767.0f));
+	}
+
+	// 15 bits per component, the index of the dropped component goes into the top bits of the first two
+	packed[0] = static_cast<std::uint16_t>(quantized[0] | ((largest & 1) << 15));
+	packed[1] = static_cast<std::uint16_t>(quantized[1] | ((largest >> 1) << 15));
+	packed[2] = quantized[2];
+}
+
+glm::quat CompressedClip::unpackQuat(std::uint16_t const* packed)
+{
+	int largest = (packed[0] >> 15) | ((packed[1] >> 15) << 1);
+
+	float components[4];
+	float sumSq = 0.0f;
+	for (int i = 0, n = 0; i < 4; ++i) {
+		if (i == largest)
+			continue;
+		float unit = static_cast<float>(packed[n++] & 0x7FFF) / 32767.0f;
+		components[i] = (unit * 2.0f - 1.0f) * kQuatComponentRange;
+		sumSq += components[i] * components[i];
+	}
+	components[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+
+	return glm::quat(components[3], components[0], components[1], components[2]);
+}
+
+void CompressedClip::clear()
+{
+	groups_.clear();
+	duration_ = 0.0f;
+	timeScale_ = 0.0f;
+	channelCount_ = 0;
+	compressed_ = false;
+	report_ = CompressionReport{};
+}
+
+CompressedClip::TrackGroup& CompressedClip::groupFor_(TargetPath path, bool step)
+{
+	for (auto& group : groups_) {
+		if (group.path == path && group.step == step)
+			return group;
+	}
+
+	TrackGroup& group = groups_.emplace_back();
+	group.path = path;
+	group.step = step;
+	group.keyOffsets.push_back(0);
+	return group;
+}
+
+void CompressedClip::compress(std::vector<std::shared_ptr<AnimationChannel>> const& channels, std::vector<std::shared_ptr<Node>> const& nodes,
+															float tolerance)
+{
+	clear();
+	channelCount_ = channels.size();
+	report_.tolerance = tolerance;
+
+	for (auto const& channel : channels) {
+		if (channel)
+			duration_ = std::max(duration_, channel->getMaxTime());
+	}
+	timeScale_ = duration_ > 0.0f ? kMaxQuantized / duration_ : 0.0f;
+
+	std::vector<int> pathCounts(nodes.size(), 0);
+	for (auto const& channel : channels) {
+		if (channel && channel->targetNode >= 0 && static_cast<std::size_t>(channel->targetNode) < nodes.size())
+			++pathCounts[channel->targetNode];
+	}
+	std::vector<JointBudget> budgets = computeJointBudgets(nodes, pathCounts, tolerance);
+
+	for (std::size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex) {
+		auto const& channel = channels[channelIndex];
+		if (!channel)
+			continue;
+
+		// Raw size as loaded: float key times plus the full precision values (cubic tangents included)
+		std::size_t valueSize = channel->targetPath == TargetPath::ROTATION ? sizeof(glm::quat) : sizeof(glm::vec3);
+		std::size_t valueCount = channel->getRotations().size() + channel->getTranslations().size() + channel->getScalings().size();
+		report_.rawBytes += channel->getTimings().size() * sizeof(float) + valueCount * valueSize;
+		report_.rawKeys += channel->getTimings().size();
+
+		int const targetNode = channel->targetNode;
+		if (targetNode < 0 || static_cast<std::size_t>(targetNode) >= nodes.size())
+			continue;
+
+		SampledTrack source = sampleChannel(*channel);
+		if (source.times.empty())
+			continue;
+
+		TargetPath const path = channel->targetPath;
+		bool const isRotation = path == TargetPath::ROTATION;
+		JointBudget const& budget = budgets[targetNode];
+		float const budgetForPath = isRotation ? budget.rotation : (path == TargetPath::TRANSLATION ? budget.translation : budget.scale);
+
+		// Quantize the times, samples that collapse onto the previous quantized time are dropped
+		std::vector<std::uint16_t> times;
+		std::vector<glm::vec4> reference;
+		for (std::size_t k = 0; k < source.times.size(); ++k) {
+			float scaled = std::clamp(source.times[k] * timeScale_, 0.0f, kMaxQuantized);
+			std::uint16_t time = static_cast<std::uint16_t>(std::lround(scaled));
+			if (!times.empty() && time <= times.back())
+				continue;
+			times.push_back(time);
+			reference.push_back(source.values[k]);
+		}
+		std::size_t const sampleCount = times.size();
+
+		// Quantize the values, the reduction below measures errors on what the runtime will actually decode
+		glm::vec3 rangeMin(0.0f), rangeScale(0.0f);
+		std::vector<std::uint16_t> packed(sampleCount * 3);
+		std::vector<glm::vec4> decoded(sampleCount);
+		if (isRotation) {
+			for (std::size_t k = 0; k < sampleCount; ++k) {
+				packQuat(toQuat(reference[k]), &packed[k * 3]);
+				glm::quat q = unpackQuat(&packed[k * 3]);
+				decoded[k] = glm::vec4(q.x, q.y, q.z, q.w);
+			}
+		}
+		else {
+			glm::vec3 rangeMax(reference[0]);
+			rangeMin = glm::vec3(reference[0]);
+			for (auto const& v : reference) {
+				rangeMin = glm::min(rangeMin, glm::vec3(v));
+				rangeMax = glm::max(rangeMax, glm::vec3(v));
+			}
+			rangeScale = (rangeMax - rangeMin) / kMaxQuantized;
+
+			for (std::size_t k = 0; k < sampleCount; ++k) {
+				for (int c = 0; c < 3; ++c) {
+					float unit = rangeScale[c] > 0.0f ? (reference[k][c] - rangeMin[c]) / rangeScale[c] : 0.0f;
+					packed[k * 3 + c] = static_cast<std::uint16_t>(std::lround(std::clamp(unit, 0.0f, kMaxQuantized)));
+					decoded[k][c] = rangeMin[c] + static_cast<float>(packed[k * 3 + c]) * rangeScale[c];
+				}
+			}
+		}
+
+		auto error = [&](glm::vec4 const& value, std::size_t k) {
+			return isRotation ? rotationError(toQuat(value), toQuat(reference[k])) : glm::length(glm::vec3(value) - glm::vec3(reference[k]));
+		};
+		auto interpolate = [&](std::size_t a, std::size_t b, std::size_t k) {
+			float t = static_cast<float>(times[k] - times[a]) / static_cast<float>(times[b] - times[a]);
+			glm::vec4 from = decoded[a], to = decoded[b];
+			if (isRotation && glm::dot(from, to) < 0.0f)
+				to = -to;
+			glm::vec4 value = from + (to - from) * t;
+			return isRotation ? glm::normalize(value) : value;
+		};
+
+		// Key reduction: a constant track keeps one key, otherwise each kept key spans as far as the error budget allows
+		std::vector<std::size_t> kept{0};
+		bool constant = true;
+		for (std::size_t k = 1; k < sampleCount && constant; ++k)
+			constant = error(decoded[0], k) <= budgetForPath;
+
+		if (!constant && source.step) {
+			for (std::size_t k = 1; k < sampleCount; ++k) {
+				if (error(decoded[kept.back()], k) > budgetForPath)
+					kept.push_back(k);
+			}
+		}
+		else if (!constant) {
+			std::size_t start = 0;
+			for (std::size_t end = 2; end < sampleCount; ++end) {
+				bool fits = true;
+				for (std::size_t k = start + 1; k < end && fits; ++k)
+					fits = error(interpolate(start, end, k), k) <= budgetForPath;
+
+				if (!fits) {
+					start = end - 1;
+					kept.push_back(start);
+				}
+			}
+			if (sampleCount > 1)
+				kept.push_back(sampleCount - 1);
+		}
+
+		TrackGroup& group = groupFor_(path, source.step);
+		group.targetNodes.push_back(targetNode);
+		group.channelIndices.push_back(static_cast<std::uint32_t>(channelIndex));
+		if (!isRotation) {
+			group.rangeMin.push_back(rangeMin);
+			group.rangeScale.push_back(rangeScale);
+		}
+		for (std::size_t k : kept) {
+			group.times.push_back(times[k]);
+			group.keys.insert(group.keys.end(), packed.begin() + k * 3, packed.begin() + k * 3 + 3);
+		}
+		group.keyOffsets.push_back(static_cast<std::uint32_t>(group.times.size()));
+		report_.compressedKeys += kept.size();
+	}
+
+	compressed_ = true;
+	report_.compressedBytes = computeBytes_();
+
+	// std::cout << "[CompressedClip INFO] " << report_.rawBytes << " -> " << report_.compressedBytes << " bytes, " << report_.rawKeys << " -> "
+	// << report_.compressedKeys << " keys" << std::endl;
+}
+
+std::size_t CompressedClip::computeBytes_() const
+{
+	std::size_t bytes = sizeof(*this);
+	for (auto const& group : groups_) {
+		bytes += sizeof(TrackGroup);
+		bytes += group.targetNodes.size() * sizeof(int) + group.channelIndices.size() * sizeof(std::uint32_t);
+		bytes += group.keyOffsets.size() * sizeof(std::uint32_t);
+		bytes += group.times.size() * sizeof(std::uint16_t) + group.keys.size() * sizeof(std::uint16_t);
+		bytes += (group.rangeMin.size() + group.rangeScale.size()) * sizeof(glm::vec3);
+	}
+	return bytes;
+}
+
+std::vector<int> CompressedClip::getTargetNodes(TargetPath path) const
+{
+	std::vector<int> targets;
+	for (auto const& group : groups_) {
+		if (group.path == path)
+			targets.insert(targets.end(), group.targetNodes.begin(), group.targetNodes.end());
+	}
+
+	std::sort(targets.begin(), targets.end());
+	targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+	return targets;
+}
+
+std::vector<CompressedClip::TrackTimes> CompressedClip::getTrackTimes() const
+{
+	std::vector<TrackTimes> tracks;
+	for (auto const& group : groups_) {
+		for (std::size_t i = 0; i + 1 < group.keyOffsets.size(); ++i)
+			tracks.push_back(TrackTimes{group.times.data() + group.keyOffsets[i], group.keyOffsets[i + 1] - group.keyOffsets[i]});
+	}
+	return tracks;
+}
+
+void CompressedClip::evaluate(Pose& pose, float time, std::size_t* cursors) const
+{
+	for (auto const& group : groups_)
+		evaluateGroup_(group, pose, time, cursors);
+}
+
+void CompressedClip::evaluateGroup_(TrackGroup const& group, Pose& pose, float time, std::size_t* cursors) const
+{
+	std::size_t const trackCount = group.targetNodes.size();
+	if (trackCount == 0)
+		return;
+
+	using AnimationKernels::Staging;
+	Staging& s = AnimationKernels::threadStaging();
+	s.reserve(trackCount);
+	float* t = s.plane(Staging::kFactorPlane);
+	bool const isRotation = group.path == TargetPath::ROTATION;
+	int const componentCount = isRotation ? 4 : 3;
+
+	// Decode key 'k' of track 'i' into lanes [plane, plane + componentCount)
+	auto decode = [&](std::size_t i, std::size_t k, int plane, bool alignToA) {
+		std::uint16_t const* key = group.keys.data() + k * 3;
+		if (isRotation) {
+			glm::quat q = unpackQuat(key);
+			float components[4] = {q.x, q.y, q.z, q.w};
+
+			// Blend along the shortest arc, the stored keys always have a positive largest component
+			float sign = 1.0f;
+			if (alignToA) {
+				float dot = 0.0f;
+				for (int c = 0; c < 4; ++c)
+					dot += components[c] * s.plane(c)[i];
+				sign = dot < 0.0f ? -1.0f : 1.0f;
+			}
+			for (int c = 0; c < 4; ++c)
+				s.plane(plane + c)[i] = components[c] * sign;
+		}
+		else {
+			for (int c = 0; c < 3; ++c)
+				s.plane(plane + c)[i] = group.rangeMin[i][c] + static_cast<float>(key[c]) * group.rangeScale[i][c];
+		}
+	};
+
+	// Gather: locate each track's segment in quantized time and decompress its two keys into the SoA lanes
+	float const quantizedTime = std::clamp(time, 0.0f, duration_) * timeScale_;
+	for (std::size_t i = 0; i < trackCount; ++i) {
+		std::uint32_t const offset = group.keyOffsets[i];
+		std::size_t const keyCount = group.keyOffsets[i + 1] - offset;
+		std::uint16_t const* times = group.times.data() + offset;
+
+		std::size_t segment = 0;
+		float factor = 0.0f;
+		if (keyCount > 1 && quantizedTime >= times[keyCount - 1]) {
+			segment = keyCount - 2;
+			factor = 1.0f;
+		}
+		else if (keyCount > 1 && quantizedTime > times[0]) {
+			std::size_t freshCursor = 0;
+			std::size_t& cursor = cursors ? cursors[group.channelIndices[i]] : freshCursor;
+			segment = AnimationKernels::findKeyframe(times, keyCount, quantizedTime, cursor);
+			factor = (quantizedTime - times[segment]) / static_cast<float>(times[segment + 1] - times[segment]);
+		}
+
+		if (group.step || keyCount == 1) {
+			// Constant over the segment: both lerp inputs hold the same key
+			std::size_t key = offset + (factor >= 1.0f ? keyCount - 1 : segment);
+			decode(i, key, 0, false);
+			decode(i, key, 4, false);
+			t[i] = 0.0f;
+		}
+		else {
+			decode(i, offset + segment, 0, false);
+			decode(i, offset + segment + 1, 4, true);
+			t[i] = factor;
+		}
+	}
+	s.padLanes(trackCount);
+
+	// Batched evaluation with the same kernels as the uncompressed tracks
+	AnimationKernels::lerp(s, componentCount);
+	if (isRotation)
+		AnimationKernels::normalizeQuat(s);
+
+	// Scatter into the pose's TRS
+	AnimationKernels::scatter(s, group.path, group.targetNodes, pose);
+}
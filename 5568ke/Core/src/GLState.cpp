@@ -0,0 +1,192 @@
+#include "GLState.hpp"
+
+#include <iostream>
+
+namespace {
+int targetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D:
+		return 0;
+	case GL_TEXTURE_CUBE_MAP:
+		return 1;
+	case GL_TEXTURE_BUFFER:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+int capIndex(GLenum cap)
+{
+	switch (cap) {
+	case GL_DEPTH_TEST:
+		return 0;
+	case GL_CULL_FACE:
+		return 1;
+	case GL_BLEND:
+		return 2;
+	case GL_PROGRAM_POINT_SIZE:
+		return 3;
+	default:
+		return -1;
+	}
+}
+} // namespace
+
+void GLState::beginFrame()
+{
+	lastFrame_ = frame_;
+	frame_ = GLStateCounters();
+	invalidate();
+}
+
+void GLState::invalidate()
+{
+	program_ = vao_ = activeUnit_ = kUnknown;
+	for (auto& unit : textures_)
+		for (auto& texture : unit)
+			texture = kUnknown;
+	for (auto& cap : caps_)
+		cap = kUnknown;
+	depthMask_ = depthFunc_ = cullFace_ = polygonMode_ = kUnknown;
+	lineWidth_ = -1.0f;
+}
+
+bool GLState::change_(long long& current, long long value)
+{
+	if (current == value) {
+		++frame_.skipped;
+		return false;
+	}
+	current = value;
+	++frame_.issued;
+	return true;
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (change_(program_, program))
+		glUseProgram(program);
+}
+
+void GLState::forgetProgram(GLuint program)
+{
+	if (program_ == static_cast<long long>(program))
+		program_ = kUnknown;
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (change_(vao_, vao))
+		glBindVertexArray(vao);
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+	int index = targetIndex(target);
+	if (unit >= kTextureUnits || index < 0) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		activeUnit_ = unit;
+		frame_.issued += 2;
+		return;
+	}
+
+	if (textures_[unit][index] == static_cast<long long>(texture)) {
+		++frame_.skipped;
+		return;
+	}
+
+	// Selecting the unit is only needed when it changes
+	if (change_(activeUnit_, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+	textures_[unit][index] = texture;
+	glBindTexture(target, texture);
+	++frame_.issued;
+}
+
+void GLState::setEnabled(GLenum cap, bool enabled)
+{
+	int index = capIndex(cap);
+	if (index < 0)
+		++frame_.issued; // Untracked capability
+	else if (!change_(caps_[index], enabled ? 1 : 0))
+		return;
+
+	if (enabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+bool GLState::isEnabled(GLenum cap)
+{
+	int index = capIndex(cap);
+	if (index >= 0 && caps_[index] != kUnknown)
+		return caps_[index] != 0;
+
+	// Unknown since the last invalidate(), ask the driver once
+	bool enabled = glIsEnabled(cap) == GL_TRUE;
+	if (index >= 0)
+		caps_[index] = enabled ? 1 : 0;
+	++frame_.issued;
+	return enabled;
+}
+
+void GLState::depthMask(bool enabled)
+{
+	if (change_(depthMask_, enabled ? 1 : 0))
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+bool GLState::getDepthMask()
+{
+	if (depthMask_ == kUnknown) {
+		GLboolean mask = GL_TRUE;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &mask);
+		depthMask_ = mask ? 1 : 0;
+		++frame_.issued;
+	}
+	return depthMask_ != 0;
+}
+
+void GLState::depthFunc(GLenum func)
+{
+	if (change_(depthFunc_, func))
+		glDepthFunc(func);
+}
+
+GLenum GLState::getDepthFunc()
+{
+	if (depthFunc_ == kUnknown) {
+		GLint func = GL_LESS;
+		glGetIntegerv(GL_DEPTH_FUNC, &func);
+		depthFunc_ = func;
+		++frame_.issued;
+	}
+	return static_cast<GLenum>(depthFunc_);
+}
+
+void GLState::cullFace(GLenum face)
+{
+	if (change_(cullFace_, face))
+		glCullFace(face);
+}
+
+void GLState::polygonMode(GLenum mode)
+{
+	if (change_(polygonMode_, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::lineWidth(float width)
+{
+	if (lineWidth_ == width) {
+		++frame_.skipped;
+		return;
+	}
+	lineWidth_ = width;
+	++frame_.issued;
+	glLineWidth(width);
+}
@@ -9,16 +9,22 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "AnimationInstance.hpp"
 #include "BoundingBox.hpp"
 #include "Model.hpp"
 
 // Constructors
-GameObject::GameObject(std::shared_ptr<Model> model) : name(model->modelName), model_(model) { updateTransformMatrix(); }
+GameObject::GameObject(std::shared_ptr<Model> model) : name(model->modelName), model_(model)
+{
+	createAnimation_();
+	updateTransformMatrix();
+}
 
 // Model operations
 void GameObject::setModel(std::shared_ptr<Model> newModel)
 {
 	model_ = newModel;
+	createAnimation_();
 
 	// If we don't have a name and the model has one, use it
 	if (name.empty() && model_ && !model_->modelName.empty()) {
@@ -26,6 +32,17 @@ void GameObject::setModel(std::shared_ptr<Model> newModel)
 	}
 }
 
+void GameObject::createAnimation_()
+{
+	// Every object gets its own pose, the model's clips and skeleton are shared
+	if (model_ && !model_->animations.empty() && !model_->nodes.empty())
+		animation_ = std::make_shared<AnimationInstance>(model_);
+	else
+		animation_.reset();
+}
+
+BoundingBox const& GameObject::getLocalBBox() const { return animation_ ? animation_->getLocalBBox() : model_->localSpaceBBox; }
+
 // Transform setters that need to update the matrix
 void GameObject::translate(glm::vec3 const& translation) { position += translation; }
 void GameObject::rotate(glm::vec3 const& rotationDelta) { rotationDeg += rotationDelta; }
@@ -37,9 +54,9 @@ void GameObject::updateTransformMatrix()
 {
 	transform_ = calculateTransformMatrix_();
 
-	// model_->localSpaceBBox is an AABB in model space
+	// The local box is an AABB in model space
 	if (model_) {
-		BoundingBox const& local = model_->localSpaceBBox;
+		BoundingBox const& local = getLocalBBox();
 
 		// Transform the 8 corners to world space, then clamp to AABB
 		glm::vec3 worldMin(std::numeric_limits<float>::max());
@@ -121,33 +138,8 @@ glm::vec3 GameObject::directionTo(GameObject const& other) const
 // Bounds and collision
 bool GameObject::isInFrustum(glm::mat4 const& viewProjectionMatrix) const
 {
-	if (!model_) {
-		return false;
-	}
-
-	// Get the model's bounding box
-	BoundingBox bbox = model_->localSpaceBBox;
-
-	// Transform the 8 corners of the bounding box to world space
-	glm::vec3 corners[8] = {{bbox.min.x, bbox.min.y, bbox.min.z}, {bbox.max.x, bbox.min.y, bbox.min.z}, {bbox.min.x, bbox.max.y, bbox.min.z},
-													{bbox.max.x, bbox.max.y, bbox.min.z}, {bbox.min.x, bbox.min.y, bbox.max.z}, {bbox.max.x, bbox.min.y, bbox.max.z},
-													{bbox.min.x, bbox.max.y, bbox.max.z}, {bbox.max.x, bbox.max.y, bbox.max.z}};
-
-	// Check if any corner is inside the frustum
-	for (auto const& corner : corners) {
-		glm::vec4 worldPos = transform_ * glm::vec4(corner, 1.0f);
-		glm::vec4 clipPos = viewProjectionMatrix * worldPos;
-
-		// Check if the point is within the clip space
-		if (clipPos.w > 0.0f) {
-			glm::vec3 ndc = glm::vec3(clipPos) / clipPos.w;
-			if (ndc.x >= -1.0f && ndc.x <= 1.0f && ndc.y >= -1.0f && ndc.y <= 1.0f && ndc.z >= -1.0f && ndc.z <= 1.0f) {
-				return true;
-			}
-		}
-	}
-
-	return false;
+	// Plane against box, a box with every corner outside the clip volume can still cover it (e.g. the classroom around the camera)
+	return model_ && BBoxUtil::isInsideFrustum(worldBBox, viewProjectionMatrix);
 }
 
 // Debug and utility
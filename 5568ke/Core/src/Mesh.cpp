@@ -1,64 +1,248 @@
 #include "Mesh.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "GLState.hpp"
+#include "InstanceData.hpp"
 #include "Material.hpp"
 #include "Primitive.hpp"
 #include "Shader.hpp"
 #include "Vertex.hpp"
 #include "include_5568ke.hpp"
 
-void Mesh::setup()
+namespace {
+
+// GPU layouts written by Mesh::setup, the CPU keeps the full-precision Vertex array for bounds and CPU skinning
+struct PackedVertex {
+	glm::vec3 position;
+	std::uint32_t normal;		// Octahedral, snorm16 x2
+	std::uint32_t texcoord; // Half float x2
+};
+
+template <typename BoneId> struct PackedSkinnedVertex {
+	glm::vec3 position;
+	std::uint32_t normal;
+	std::uint32_t texcoord;
+	BoneId boneIds[4];				 // uint8 when every joint index fits, uint16 otherwise
+	std::uint32_t boneWeights; // unorm8 x4, normalized to sum to one
+};
+
+// Unit vector to the octahedron, folded into the [-1, 1] square
+glm::vec2 octEncode(glm::vec3 n)
 {
-	glGenVertexArrays(1, &vao_);
-	glGenBuffers(1, &vbo_);
-	glGenBuffers(1, &ebo_);
+	float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (sum <= 0.0f)
+		return glm::vec2(0.0f); // Decodes to +Z
+
+	n /= sum;
+	glm::vec2 e(n.x, n.y);
+	if (n.z < 0.0f) {
+		e = glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return e;
+}
 
-	glBindVertexArray(vao_);
+template <typename Packed> void packCommon(Vertex const& v, Packed& out)
+{
+	out.position = v.position;
+	out.normal = glm::packSnorm2x16(octEncode(v.normal));
+	out.texcoord = glm::packHalf2x16(v.texcoord);
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+template <typename BoneId> std::vector<PackedSkinnedVertex<BoneId>> packSkinned(std::vector<Vertex> const& vertices)
+{
+	std::vector<PackedSkinnedVertex<BoneId>> packed(vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); ++i) {
+		Vertex const& v = vertices[i];
+		packCommon(v, packed[i]);
+
+		float total = v.boneWeights.x + v.boneWeights.y + v.boneWeights.z + v.boneWeights.w;
+		glm::vec4 weights = total > 0.0f ? v.boneWeights / total : glm::vec4(0.0f);
+		for (int k = 0; k < 4; ++k) {
+			// Unweighted slots are never read, the shader skips zero weights
+			packed[i].boneIds[k] = weights[k] > 0.0f ? static_cast<BoneId>(std::max(v.boneIds[k], 0)) : BoneId{0};
+		}
+		packed[i].boneWeights = glm::packUnorm4x8(weights);
+	}
+	return packed;
+}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+template <typename Packed> void uploadVertices(std::vector<Packed> const& packed)
+{
+	glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(Packed), packed.data(), GL_STATIC_DRAW);
 
-	// Position attribute
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Packed), (void*)offsetof(Packed, position));
 
-	// Normal attribute
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(Packed), (void*)offsetof(Packed, normal));
 
-	// Texcoord attribute
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(Packed), (void*)offsetof(Packed, texcoord));
+}
+
+template <typename BoneId> std::size_t uploadSkinnedVertices(std::vector<Vertex> const& vertices, GLenum boneIdType)
+{
+	using Packed = PackedSkinnedVertex<BoneId>;
+	std::vector<Packed> packed = packSkinned<BoneId>(vertices);
+	uploadVertices(packed);
 
-	// Bone ID attribute
 	glEnableVertexAttribArray(3);
-	glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIds));
+	glVertexAttribIPointer(3, 4, boneIdType, sizeof(Packed), (void*)offsetof(Packed, boneIds));
 
-	// Bone weight attribute
 	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, boneWeights));
+	glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Packed), (void*)offsetof(Packed, boneWeights));
+	return packed.size() * sizeof(Packed);
+}
+
+std::atomic<std::uint32_t> nextPrimitiveId{1};
+
+} // namespace
+
+void Mesh::setup()
+{
+	glGenVertexArrays(1, &vao_);
+	glGenBuffers(1, &vbo_);
+	glGenBuffers(1, &ebo_);
+
+	GLState::getInstance().bindVertexArray(vao_);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+	// Meshes without any skin weight get the layout without the skinning stream
+	int maxBoneId = -1;
+	for (auto const& v : vertices) {
+		for (int k = 0; k < 4; ++k) {
+			if (v.boneWeights[k] > 0.0f)
+				maxBoneId = std::max(maxBoneId, v.boneIds[k]);
+		}
+	}
+	skinned_ = maxBoneId >= 0;
+
+	if (!skinned_) {
+		std::vector<PackedVertex> packed(vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			packCommon(vertices[i], packed[i]);
+		uploadVertices(packed);
+		vertexBytes_ = packed.size() * sizeof(PackedVertex);
+	}
+	else if (maxBoneId <= 0xFF) {
+		vertexBytes_ = uploadSkinnedVertices<std::uint8_t>(vertices, GL_UNSIGNED_BYTE);
+	}
+	else {
+		vertexBytes_ = uploadSkinnedVertices<std::uint16_t>(vertices, GL_UNSIGNED_SHORT);
+	}
+
+	// Every primitive whose vertex range spans at most 65536 vertices gets 16-bit indices relative to its first vertex
+	std::vector<unsigned char> indexData;
+	for (auto& prim : primitives) {
+		unsigned int lowest = 0, highest = 0;
+		if (prim.indexCount > 0) {
+			auto range = std::minmax_element(indices.begin() + prim.indexOffset, indices.begin() + prim.indexOffset + prim.indexCount);
+			lowest = *range.first;
+			highest = *range.second;
+		}
+		prim.shortIndices = highest - lowest <= 0xFFFF;
+
+		prim.sortId = nextPrimitiveId.fetch_add(1, std::memory_order_relaxed);
+
+		// Mesh space box of the primitive, culled on its own when the mesh is only partly visible
+		prim.bounds = BBoxUtil::emptyBBox();
+		for (unsigned int i = prim.indexOffset; i < prim.indexOffset + prim.indexCount; ++i) {
+			prim.bounds.min = glm::min(prim.bounds.min, vertices[indices[i]].position);
+			prim.bounds.max = glm::max(prim.bounds.max, vertices[indices[i]].position);
+		}
+
+		prim.baseVertex = prim.shortIndices ? static_cast<int>(lowest) : 0;
+
+		// Offsets stay aligned to the index size
+		std::size_t indexSize = prim.shortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+		indexData.resize((indexData.size() + indexSize - 1) / indexSize * indexSize);
+		prim.indexByteOffset = indexData.size();
+		indexData.resize(indexData.size() + prim.indexCount * indexSize);
+
+		unsigned char* dst = indexData.data() + prim.indexByteOffset;
+		for (unsigned int i = 0; i < prim.indexCount; ++i) {
+			unsigned int index = indices[prim.indexOffset + i];
+			if (prim.shortIndices) {
+				std::uint16_t relative = static_cast<std::uint16_t>(index - lowest);
+				std::memcpy(dst + i * sizeof(relative), &relative, sizeof(relative));
+			}
+			else {
+				std::memcpy(dst + i * sizeof(index), &index, sizeof(index));
+			}
+		}
+	}
+	indexBytes_ = indexData.size();
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GLState::getInstance().bindVertexArray(0);
 }
 
 void Mesh::draw(Shader const& shader) const
 {
-	glBindVertexArray(vao_);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	bind();
+
+	// Double-sided primitives draw without culling, runs of them only toggle it once
+	GLState& state = GLState::getInstance();
+	bool cull = state.isEnabled(GL_CULL_FACE);
 
 	for (auto const& prim : primitives) {
 		if (prim.material)
 			prim.material->bind(shader);
 
-		if (prim.doubleSided)
-			glDisable(GL_CULL_FACE);
+		state.setEnabled(GL_CULL_FACE, cull && !prim.doubleSided);
+		drawPrimitive(prim);
+	}
+	state.setEnabled(GL_CULL_FACE, cull);
+}
 
-		glDrawElements(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)));
+void Mesh::bind() const
+{
+	// The VAO holds the index buffer as well
+	GLState::getInstance().bindVertexArray(vao_);
 
-		if (prim.doubleSided)
-			glEnable(GL_CULL_FACE);
+	// No skinning stream, a zero weight makes the skinned shader leave the vertices where they are
+	if (!skinned_)
+		glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void Mesh::bindInstances(unsigned int buffer, std::size_t byteOffset) const
+{
+	// Instance attributes are VAO state like the vertex streams, they advance once per instance
+	constexpr GLsizei stride = sizeof(InstanceData);
+	GLuint const location = InstanceData::kFirstLocation;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	for (GLuint c = 0; c < 4; ++c) {
+		glEnableVertexAttribArray(location + c);
+		glVertexAttribPointer(location + c, 4, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + offsetof(InstanceData, model) + c * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location + c, 1);
+	}
+	for (GLuint c = 0; c < 3; ++c) {
+		glEnableVertexAttribArray(location + 4 + c);
+		glVertexAttribPointer(location + 4 + c, 3, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + offsetof(InstanceData, normalMatrix) + c * sizeof(glm::vec3)));
+		glVertexAttribDivisor(location + 4 + c, 1);
 	}
-	glBindVertexArray(0);
+	glEnableVertexAttribArray(location + 7);
+	glVertexAttribIPointer(location + 7, 1, GL_INT, stride, (void*)(byteOffset + offsetof(InstanceData, paletteOffset)));
+	glVertexAttribDivisor(location + 7, 1);
+}
+
+void Mesh::drawPrimitive(Primitive const& prim, int instanceCount) const
+{
+	GLenum type = prim.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	if (instanceCount > 1)
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, prim.indexCount, type, (void*)prim.indexByteOffset, instanceCount, prim.baseVertex);
+	else
+		glDrawElementsBaseVertex(GL_TRIANGLES, prim.indexCount, type, (void*)prim.indexByteOffset, prim.baseVertex);
 }
@@ -2,6 +2,8 @@
 
 #include "Model.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,50 +12,35 @@
 #include "AnimationClip.hpp"
 #include "Mesh.hpp"
 #include "Node.hpp"
+#include "PosePool.hpp"
 #include "Shader.hpp"
 
 Model::~Model() { cleanup(); }
 
-void Model::draw(Shader const& shader, glm::mat4 const& modelMatrix) const
+void Model::draw(Shader const& shader, glm::mat4 const& modelMatrix, Pose const* pose) const
 {
-	// Set the model matrix
-	shader.sendMat4("model", modelMatrix);
-
-	// For skinned models, send joint matrices to shader
-	if (!jointMatrices.empty() && animations.size() > 0) {
-		// Enable skinning
-		shader.sendBool("enableSkinning", true);
-
-		// Send joint matrices to shader
-		for (size_t i = 0; i < jointMatrices.size() && i < 100; i++) {
-			std::string uniformName = "jointMatrices[" + std::to_string(i) + "]";
-			shader.sendMat4(uniformName.c_str(), jointMatrices[i]);
-		}
-	}
-	else {
-		// Disable skinning for static meshes
-		shader.sendBool("enableSkinning", false);
-	}
+	// Objects without an animation instance share the bind pose
+	if (!pose)
+		pose = &bindPose.get();
 
 	// Handle each mesh
 	for (size_t i = 0; i < meshes.size(); i++) {
-		glm::mat4 finalTransform = modelMatrix;
-
-		// If this is a static mesh and has a node associated with it
-		if (i < meshNodeIndices.size()) {
-			int nodeIndex = meshNodeIndices[i];
-			if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < nodes.size() && nodes[nodeIndex]) {
-				// Apply node's transform to the model matrix
-				finalTransform = modelMatrix * nodes[nodeIndex]->getNodeMatrix();
-				shader.sendMat4("model", finalTransform);
-			}
-		}
-
-		// Draw the mesh
+		shader.sendMat4("model", getMeshTransform(i, modelMatrix, *pose));
 		meshes[i].draw(shader);
 	}
 }
 
+glm::mat4 Model::getMeshTransform(std::size_t mesh, glm::mat4 const& modelMatrix, Pose const& pose) const
+{
+	// If this mesh has a node associated with it, apply the node's transform to the model matrix
+	if (mesh < meshNodeIndices.size()) {
+		int nodeIndex = meshNodeIndices[mesh];
+		if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < pose.nodeCount)
+			return modelMatrix * glm::mat4(pose.worldMatrices[nodeIndex]);
+	}
+	return modelMatrix;
+}
+
 void Model::cleanup()
 {
 	// Clean up any dynamically allocated resources
@@ -64,13 +51,88 @@ void Model::cleanup()
 // Support animation functionality
 void Model::updateLocalMatrices()
 {
-	if (!rootNode) {
-		return;
+	// std::cout << "[Model] Updating matrices" << std::endl;
+	skeleton.build(nodes, rootNode);
+
+	if (bindPose.get().nodeCount != nodes.size() || bindPose.get().jointCount != jointCount)
+		bindPose = PooledPose(nodes.size(), jointCount);
+
+	Pose& pose = bindPose.get();
+	for (std::size_t i = 0; i < pose.nodeCount; ++i) {
+		if (nodes[i]) {
+			pose.translations[i] = nodes[i]->translation;
+			pose.rotations[i] = nodes[i]->rotation;
+			pose.scales[i] = nodes[i]->scale;
+		}
 	}
 
-	// std::cout << "[Model] Updating matrices" << std::endl;
-	NodeUtil::updateNodeListLocalTRSMatrix(nodes);
-	NodeUtil::updateNodeTreeMatricesRecursive(rootNode, glm::mat4(1.0f));
-	NodeUtil::updateNodeListJointMatrices(*this);
+	pose.markAllDirty();
+	composePose(pose);
 	BBoxUtil::updateLocalBBox(*this);
 }
+
+PoseUpdateStats Model::composePose(Pose& pose) const
+{
+	PoseUpdateStats stats;
+	stats.nodesRecomputed = skeleton.computeWorldMatrices(pose);
+
+	// Skinning matrices of the joints whose world matrix moved, the skeleton pass left those nodes flagged
+	if (stats.nodesRecomputed > 0 && rig) {
+		std::vector<glm::mat4> const& inverseBindMatrices = rig->inverseBindMatrices;
+		for (std::size_t i = 0; i < pose.nodeCount && i < nodeToJointMapping.size(); ++i) {
+			if (!pose.dirty[i])
+				continue;
+
+			int jointIndex = nodeToJointMapping[i];
+			if (jointIndex >= 0 && static_cast<std::size_t>(jointIndex) < pose.jointCount && static_cast<std::size_t>(jointIndex) < inverseBindMatrices.size()) {
+				pose.jointMatrices[jointIndex] = glm::mat4(pose.worldMatrices[i]) * inverseBindMatrices[jointIndex];
+				++stats.jointsRecomputed;
+			}
+		}
+	}
+
+	pose.clearDirty();
+	return stats;
+}
+
+void Model::computeClipBounds(float sampleRate, float padding)
+{
+	clipBounds.assign(animations.size(), BBoxUtil::emptyBBox());
+	if (jointCount == 0 || sampleRate <= 0.0f)
+		return;
+
+	// One scratch pose for every clip, nodes a clip does not animate stay at rest
+	PooledPose scratch(nodes.size(), jointCount);
+	Pose& pose = scratch.get();
+	Pose const& rest = bindPose.get();
+	if (pose.empty() || rest.nodeCount != pose.nodeCount)
+		return;
+
+	for (std::size_t c = 0; c < animations.size(); ++c) {
+		// Lazily loaded clips are decoded into a temporary copy, their residency is left alone
+		std::shared_ptr<AnimationClip const> clip = animations[c] ? animations[c]->decodeNow() : nullptr;
+		if (!clip || clip->getDuration() <= 0.0f)
+			continue;
+
+		std::copy_n(rest.translations, pose.nodeCount, pose.translations);
+		std::copy_n(rest.rotations, pose.nodeCount, pose.rotations);
+		std::copy_n(rest.scales, pose.nodeCount, pose.scales);
+		pose.markAllDirty();
+
+		float duration = clip->getDuration();
+		std::size_t frameCount = static_cast<std::size_t>(std::ceil(duration * sampleRate));
+		BoundingBox bounds = BBoxUtil::emptyBBox();
+		for (std::size_t f = 0; f <= frameCount; ++f) {
+			clip->setAnimationFrame(pose, std::min(static_cast<float>(f) / sampleRate, duration));
+			composePose(pose);
+			bounds = BBoxUtil::mergeBBox(bounds, BBoxUtil::computeLocalBBox(*this, pose));
+		}
+
+		if (BBoxUtil::isEmptyBBox(bounds))
+			continue;
+
+		glm::vec3 pad = (bounds.max - bounds.min) * padding;
+		clipBounds[c] = {bounds.min - pad, bounds.max + pad};
+		// std::cout << "[Model INFO] Clip bounds of '" << clip->clipName << "' from " << frameCount + 1 << " samples" << std::endl;
+	}
+}
@@ -0,0 +1,119 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "PosePool.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// Sections are rounded to 16 bytes so every array in a block stays aligned for SIMD loads
+constexpr std::size_t alignSection(std::size_t bytes) { return (bytes + 15) / 16 * 16; }
+
+} // namespace
+
+PosePool& PosePool::getInstance()
+{
+	// Never destroyed, poses owned by other singletons (e.g. the scene's objects) are released during static destruction
+	static PosePool* instance = new PosePool();
+	return *instance;
+}
+
+std::size_t PosePool::blockBytes_(std::size_t nodeCount, std::size_t jointCount)
+{
+	return alignSection(nodeCount * sizeof(glm::mat4x3)) + alignSection(jointCount * sizeof(glm::mat4)) + alignSection(nodeCount * sizeof(glm::quat)) +
+				 2 * alignSection(nodeCount * sizeof(glm::vec3)) + alignSection(nodeCount * sizeof(std::uint8_t));
+}
+
+Pose PosePool::layout_(std::byte* block, std::size_t nodeCount, std::size_t jointCount)
+{
+	// Matrices first, the block itself is the world matrix pointer so release can find it again
+	Pose pose;
+	pose.nodeCount = nodeCount;
+	pose.jointCount = jointCount;
+
+	std::byte* p = block;
+	pose.worldMatrices = reinterpret_cast<glm::mat4x3*>(p);
+	p += alignSection(nodeCount * sizeof(glm::mat4x3));
+	pose.jointMatrices = reinterpret_cast<glm::mat4*>(p);
+	p += alignSection(jointCount * sizeof(glm::mat4));
+	pose.rotations = reinterpret_cast<glm::quat*>(p);
+	p += alignSection(nodeCount * sizeof(glm::quat));
+	pose.translations = reinterpret_cast<glm::vec3*>(p);
+	p += alignSection(nodeCount * sizeof(glm::vec3));
+	pose.scales = reinterpret_cast<glm::vec3*>(p);
+	p += alignSection(nodeCount * sizeof(glm::vec3));
+	pose.dirty = reinterpret_cast<std::uint8_t*>(p);
+
+	std::uninitialized_fill_n(pose.worldMatrices, nodeCount, glm::mat4x3(1.0f));
+	std::uninitialized_fill_n(pose.jointMatrices, jointCount, glm::mat4(1.0f));
+	std::uninitialized_fill_n(pose.rotations, nodeCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	std::uninitialized_fill_n(pose.translations, nodeCount, glm::vec3(0.0f));
+	std::uninitialized_fill_n(pose.scales, nodeCount, glm::vec3(1.0f));
+	std::uninitialized_fill_n(pose.dirty, nodeCount, std::uint8_t{1});
+	return pose;
+}
+
+Pose PosePool::acquire(std::size_t nodeCount, std::size_t jointCount)
+{
+	if (nodeCount == 0)
+		return Pose{};
+
+	std::byte* block = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		SizeClass& sizeClass = classes_[(static_cast<std::uint64_t>(nodeCount) << 32) | jointCount];
+
+		if (sizeClass.freeBlocks.empty()) {
+			// Carve a new slab into blocks of this class
+			sizeClass.blockBytes = blockBytes_(nodeCount, jointCount);
+			sizeClass.slabs.push_back(std::make_unique<std::byte[]>(sizeClass.blockBytes * kBlocksPerSlab));
+			std::byte* slab = sizeClass.slabs.back().get();
+			for (std::size_t i = kBlocksPerSlab; i-- > 0;)
+				sizeClass.freeBlocks.push_back(slab + i * sizeClass.blockBytes);
+
+			// std::cout << "[PosePool INFO] New slab for " << nodeCount << " nodes, " << jointCount << " joints" << std::endl;
+		}
+
+		block = sizeClass.freeBlocks.back();
+		sizeClass.freeBlocks.pop_back();
+		++sizeClass.blocksInUse;
+	}
+
+	return layout_(block, nodeCount, jointCount);
+}
+
+void PosePool::release(Pose& pose)
+{
+	if (pose.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = classes_.find((static_cast<std::uint64_t>(pose.nodeCount) << 32) | pose.jointCount);
+		if (it != classes_.end()) {
+			it->second.freeBlocks.push_back(reinterpret_cast<std::byte*>(pose.worldMatrices));
+			--it->second.blocksInUse;
+		}
+	}
+	pose = Pose{};
+}
+
+std::size_t PosePool::getBlocksInUse() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::size_t count = 0;
+	for (auto const& [key, sizeClass] : classes_)
+		count += sizeClass.blocksInUse;
+	return count;
+}
+
+std::size_t PosePool::getReservedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::size_t bytes = 0;
+	for (auto const& [key, sizeClass] : classes_)
+		bytes += sizeClass.slabs.size() * sizeClass.blockBytes * kBlocksPerSlab;
+	return bytes;
+}
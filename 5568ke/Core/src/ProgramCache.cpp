@@ -0,0 +1,161 @@
+#include "ProgramCache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "Shader.hpp"
+
+namespace {
+// KHR_parallel_shader_compile, not part of the core profile glad loads
+constexpr unsigned int kMaxCompilerThreads = 0xFFFFFFFFu; // Let the driver pick
+typedef void(APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+// Stored ahead of every binary
+struct BinaryHeader {
+	std::uint32_t magic;
+	std::uint32_t format; // GLenum from glGetProgramBinary
+	std::uint64_t key;
+	std::uint32_t length;
+};
+constexpr std::uint32_t kBinaryMagic = 0x4e494250; // "PBIN"
+
+std::uint64_t hashString(std::uint64_t hash, std::string const& text)
+{
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+} // namespace
+
+void ProgramCache::init_()
+{
+	if (initialized_)
+		return;
+	initialized_ = true;
+
+	auto glString = [](GLenum name) {
+		char const* text = reinterpret_cast<char const*>(glGetString(name));
+		return std::string(text ? text : "");
+	};
+	driver_ = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+	// Program binaries are core in 4.1, a driver may still offer no formats at all
+	GLint formats = 0;
+	if (GLAD_GL_VERSION_4_1 && glGetProgramBinary && glProgramBinary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	binaries_ = formats > 0;
+
+	if (binaries_) {
+		std::error_code error;
+		std::filesystem::create_directories(directory_, error);
+		binaries_ = !error;
+	}
+
+	MaxShaderCompilerThreadsProc maxThreads = nullptr;
+	if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+		maxThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+	else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		maxThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+	if (maxThreads)
+		maxThreads(kMaxCompilerThreads);
+
+	// std::cout << "[ProgramCache INFO] " << driver_ << ", binaries " << (binaries_ ? "on" : "off") << ", parallel compile "
+	// 					<< (maxThreads ? "on" : "off") << std::endl;
+}
+
+bool ProgramCache::binariesSupported()
+{
+	init_();
+	return binaries_;
+}
+
+std::uint64_t ProgramCache::makeKey(std::string const& vertSource, std::string const& fragSource)
+{
+	init_();
+	std::uint64_t hash = 14695981039346656037ull;
+	hash = hashString(hash, driver_);
+	hash = hashString(hash, vertSource);
+	hash = hashString(hash, fragSource);
+	return hash;
+}
+
+std::string ProgramCache::getPath_(std::uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory_ + "/" + name;
+}
+
+bool ProgramCache::load(std::uint64_t key, GLuint program)
+{
+	if (!binariesSupported())
+		return false;
+
+	std::ifstream file(getPath_(key), std::ios::binary);
+	if (!file)
+		return false;
+
+	BinaryHeader header{};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kBinaryMagic || header.key != key)
+		return false;
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+		return false;
+
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+	return true;
+}
+
+void ProgramCache::store(std::uint64_t key, GLuint program)
+{
+	if (!binariesSupported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(static_cast<std::size_t>(length));
+	GLenum format = 0;
+	glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+	BinaryHeader header{kBinaryMagic, format, key, static_cast<std::uint32_t>(length)};
+	std::ofstream file(getPath_(key), std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(binary.data(), length);
+	// if (!file)
+	// 	std::cout << "[ProgramCache ERROR] Cannot write " << getPath_(key) << std::endl;
+}
+
+void ProgramCache::reject(std::uint64_t key)
+{
+	std::error_code error;
+	std::filesystem::remove(getPath_(key), error);
+	++stats_.rejectedBinaries;
+}
+
+void ProgramCache::beginBatch()
+{
+	init_();
+	batching_ = true;
+}
+
+void ProgramCache::endBatch()
+{
+	batching_ = false;
+
+	// Every compile of the batch was issued already, the first status check waits for whatever is still in flight
+	std::vector<Shader*> pending;
+	pending.swap(pending_);
+	for (Shader* shader : pending)
+		shader->finishLink();
+
+	// std::cout << "[ProgramCache INFO] " << stats_.cachedPrograms << " cached, " << stats_.compiledPrograms << " compiled, "
+	// 					<< stats_.programMs << " ms" << std::endl;
+}
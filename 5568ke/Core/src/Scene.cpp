@@ -8,6 +8,7 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "AnimationInstance.hpp"
 #include "BoundingBox.hpp"
 #include "GlobalAnimationState.hpp"
 #include "Model.hpp"
@@ -123,7 +124,7 @@ void Scene::setupCameraToViewScene(float padding)
 			continue;
 
 		GameObject& gameObject = *goPtr;
-		BoundingBox local = gameObject.getModel()->localSpaceBBox;
+		BoundingBox local = gameObject.getLocalBBox();
 
 		// 8 corner
 		glm::vec3 corners[8] = {
@@ -168,7 +169,7 @@ void Scene::setupCameraToViewGameObject(std::string const& gameObjectName, float
 	worldBounds.min = glm::vec3(std::numeric_limits<float>::max());
 	worldBounds.max = glm::vec3(std::numeric_limits<float>::lowest());
 
-	BoundingBox local = gameObject.getModel()->localSpaceBBox;
+	BoundingBox local = gameObject.getLocalBBox();
 	glm::mat4 toWorldMatrix = gameObject.getTransform(); // Model matrix of MVP transformation
 
 	glm::vec3 corners[8] = {
@@ -1,28 +1,46 @@
 #include "Shader.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include "GLState.hpp"
+#include "ProgramCache.hpp"
+#include "UniformBlocks.hpp"
+
 namespace {
 unsigned int compileStage(std::string const& src, GLenum type)
 {
 	unsigned int id = glCreateShader(type);
 	char const* s = src.c_str();
 	glShaderSource(id, 1, &s, nullptr);
-	glCompileShader(id);
-	int ok;
-	glGetShaderiv(id, GL_COMPILE_STATUS, &ok);
-	if (!ok) {
-		char log[1024];
-		glGetShaderInfoLog(id, 1024, nullptr, log);
-		// std::cout << "[Shader ERROR] Shader error:\n" << log << '\n';
-	}
+	glCompileShader(id); // The status is checked in Shader::finishLink(), asking now would wait for the compile
 	return id;
 }
 
+// Inserts the defines right after the #version directive, which has to stay the first statement of the source
+std::string addDefines(std::string src, std::vector<std::string> const& defines)
+{
+	if (defines.empty())
+		return src;
+
+	std::size_t version = src.find("#version");
+	std::size_t at = version == std::string::npos ? 0 : src.find('\n', version);
+	at = at == std::string::npos ? src.size() : at + 1;
+
+	std::string block;
+	for (auto const& define : defines)
+		block += "#define " + define + "\n";
+	block += "#line 2\n"; // Keep the compiler's line numbers matching the file
+	src.insert(at, block);
+	return src;
+}
+
 std::string loadFile(std::string const& path)
 {
 	std::ifstream f(path);
@@ -34,12 +52,34 @@ std::string loadFile(std::string const& path)
 	ss << f.rdbuf();
 	return ss.str();
 }
+
+// FNV-1a over the name, the key of the uniform tables
+std::uint64_t hashName(char const* name, std::size_t length)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (std::size_t i = 0; i < length; ++i) {
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+std::uint64_t hashName(char const* name) { return hashName(name, std::char_traits<char>::length(name)); }
+
+// GLSL 330 cannot declare block bindings, programs using a shared block get its binding point after linking
+void bindUniformBlock(unsigned int program, char const* name, unsigned int binding)
+{
+	GLuint index = glGetUniformBlockIndex(program, name);
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, index, binding);
+}
 } // namespace
 
-void Shader::resetShaderPath(std::string const& v, std::string const& f)
+void Shader::resetShaderPath(std::string const& v, std::string const& f, std::vector<std::string> const& defines)
 {
 	vsPath_ = v;
 	fsPath_ = f;
+	defines_ = defines;
 	reload();
 }
 
@@ -48,80 +88,283 @@ void Shader::reload()
 	if (vsPath_.empty() || fsPath_.empty())
 		return;
 
-	if (program_)
+	auto start = std::chrono::steady_clock::now();
+	if (program_) {
+		GLState::getInstance().forgetProgram(program_);
 		glDeleteProgram(program_);
+	}
 
-	unsigned int vs = compileStage(loadFile(vsPath_), GL_VERTEX_SHADER);
-	unsigned int fs = compileStage(loadFile(fsPath_), GL_FRAGMENT_SHADER);
+	vsSource_ = addDefines(loadFile(vsPath_), defines_);
+	fsSource_ = addDefines(loadFile(fsPath_), defines_);
 
+	// A stored binary skips compiling altogether, whether the driver accepted it shows in the link status
+	ProgramCache& cache = ProgramCache::getInstance();
+	cacheKey_ = cache.makeKey(vsSource_, fsSource_);
 	program_ = glCreateProgram();
-	glAttachShader(program_, vs);
-	glAttachShader(program_, fs);
+	fromCache_ = cache.load(cacheKey_, program_);
+	if (!fromCache_)
+		compileAndLink_();
+	cache.getStats().programMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Batched programs are checked once the whole batch was issued, see ProgramCache
+	if (cache.isBatching())
+		cache.defer(this);
+	else
+		finishLink();
+}
+
+void Shader::compileAndLink_()
+{
+	// Only issued here, nothing waits for the driver before finishLink()
+	vs_ = compileStage(vsSource_, GL_VERTEX_SHADER);
+	fs_ = compileStage(fsSource_, GL_FRAGMENT_SHADER);
+
+	glAttachShader(program_, vs_);
+	glAttachShader(program_, fs_);
+	if (ProgramCache::getInstance().binariesSupported())
+		glProgramParameteri(program_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program_);
+}
+
+void Shader::finishLink()
+{
+	auto start = std::chrono::steady_clock::now();
+	ProgramCache& cache = ProgramCache::getInstance();
 
 	GLint success;
-	glGetShaderiv(vs, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		char infoLog[512];
-		glGetShaderInfoLog(vs, 512, NULL, infoLog);
-		// std::cout << "[Shader ERROR] Vertex shader compilation failed: " << infoLog << std::endl;
+	glGetProgramiv(program_, GL_LINK_STATUS, &success);
+	if (fromCache_ && !success) {
+		// Stale binary (e.g. a driver update with the same version string), compile it again and replace it
+		cache.reject(cacheKey_);
+		GLState::getInstance().forgetProgram(program_);
+		glDeleteProgram(program_);
+		program_ = glCreateProgram();
+		fromCache_ = false;
+		compileAndLink_();
 	}
 
-	glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		char infoLog[512];
-		glGetShaderInfoLog(fs, 512, NULL, infoLog);
-		// std::cout << "[Shader ERROR] Fragment shader compilation failed: " << infoLog << std::endl;
+	if (fromCache_)
+		++cache.getStats().cachedPrograms;
+	else {
+		++cache.getStats().compiledPrograms;
+
+		glGetShaderiv(vs_, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetShaderInfoLog(vs_, 512, NULL, infoLog);
+			// std::cout << "[Shader ERROR] Vertex shader compilation failed: " << infoLog << std::endl;
+		}
+
+		glGetShaderiv(fs_, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetShaderInfoLog(fs_, 512, NULL, infoLog);
+			// std::cout << "[Shader ERROR] Fragment shader compilation failed: " << infoLog << std::endl;
+		}
+
+		// Check program linking status
+		glGetProgramiv(program_, GL_LINK_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetProgramInfoLog(program_, 512, NULL, infoLog);
+			// std::cout << "[Shader ERROR] Shader program linking failed: " << infoLog << std::endl;
+		}
+		else
+			cache.store(cacheKey_, program_);
+
+		glDeleteShader(vs_);
+		glDeleteShader(fs_);
+		vs_ = fs_ = 0;
 	}
 
-	// Check program linking status
-	glGetProgramiv(program_, GL_LINK_STATUS, &success);
-	if (!success) {
-		char infoLog[512];
-		glGetProgramInfoLog(program_, 512, NULL, infoLog);
-		// std::cout << "[Shader ERROR] Shader program linking failed: " << infoLog << std::endl;
+	vsSource_.clear();
+	fsSource_.clear();
+	reflectUniforms_();
+	cache.getStats().programMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Shader::reflectUniforms_()
+{
+	locations_.clear();
+	warned_.clear();
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+	if (linked) {
+		bindUniformBlock(program_, FrameBlock::kName, FrameBlock::kBinding);
+		bindUniformBlock(program_, DrawBlock::kName, DrawBlock::kBinding);
+
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+		std::vector<char> name(static_cast<std::size_t>(std::max(maxLength, 1)));
+		for (GLint i = 0; i < count; ++i) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(program_, static_cast<GLuint>(i), maxLength, &length, &size, &type, name.data());
+
+			// Members of uniform blocks have no location
+			int loc = glGetUniformLocation(program_, name.data());
+			if (loc == -1)
+				continue;
+
+			locations_[hashName(name.data(), static_cast<std::size_t>(length))] = loc;
+
+			// Arrays are reported as "name[0]", the plain name addresses the first element as well
+			if (length > 3 && std::char_traits<char>::compare(name.data() + length - 3, "[0]", 3) == 0)
+				locations_[hashName(name.data(), static_cast<std::size_t>(length) - 3)] = loc;
+		}
+	}
+
+	applySamplerUnits_();
+
+	// Handles resolved before this link keep their slots
+	for (auto& slot : slots_) {
+		auto it = locations_.find(slot.hash);
+		slot.location = it != locations_.end() ? it->second : -1;
+	}
+}
+
+void Shader::setSamplerUnit(char const* name, int unit)
+{
+	auto it = std::find_if(samplerUnits_.begin(), samplerUnits_.end(), [&](auto const& sampler) { return sampler.first == name; });
+	if (it != samplerUnits_.end())
+		it->second = unit;
+	else
+		samplerUnits_.emplace_back(name, unit);
+	applySamplerUnits_();
+}
+
+void Shader::applySamplerUnits_()
+{
+	if (samplerUnits_.empty() || locations_.empty())
+		return;
+
+	// GL 3.3 has no glProgramUniform, briefly make this the current program
+	GLState& state = GLState::getInstance();
+	GLuint previous = state.getProgram();
+	state.useProgram(program_);
+	for (auto const& [name, unit] : samplerUnits_) {
+		auto it = locations_.find(hashName(name.c_str()));
+		if (it != locations_.end())
+			glUniform1i(it->second, unit);
 	}
+	state.useProgram(previous);
+}
+
+int Shader::resolveSlot_(char const* name)
+{
+	std::uint64_t hash = hashName(name);
+	for (std::size_t i = 0; i < slots_.size(); ++i)
+		if (slots_[i].hash == hash)
+			return static_cast<int>(i);
+
+	auto it = locations_.find(hash);
+	slots_.push_back({name, hash, it != locations_.end() ? it->second : -1});
+	return static_cast<int>(slots_.size() - 1);
+}
+
+int Shader::slotLocation_(int slot) const
+{
+	if (slot < 0 || slot >= static_cast<int>(slots_.size()))
+		return -1;
+
+	UniformSlot const& s = slots_[static_cast<std::size_t>(slot)];
+	if (s.location == -1)
+		warnMissing_(s.name.c_str(), s.hash);
+	return s.location;
+}
+
+int Shader::getUniformLocation(char const* name) const
+{
+	std::uint64_t hash = hashName(name);
+	auto it = locations_.find(hash);
+	if (it != locations_.end())
+		return it->second;
+
+	warnMissing_(name, hash);
+	return -1;
+}
+
+void Shader::warnMissing_(char const* name, std::uint64_t hash) const
+{
+	// Once per program, not every frame
+	if (warned_.insert(hash).second)
+		std::cout << "[Shader] Warning: uniform '" << name << "' not found in '" << vsPath_ << "'.\n";
+}
+
+void Shader::bind() const { GLState::getInstance().useProgram(program_); }
+
+void Shader::unbind() const { GLState::getInstance().useProgram(0); }
+
+void Shader::set(UniformHandle<glm::mat4> handle, glm::mat4 const& mat) const
+{
+	int loc = slotLocation_(handle.slot_);
+	if (loc != -1)
+		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
+}
 
-	glDeleteShader(vs);
-	glDeleteShader(fs);
+void Shader::set(UniformHandle<glm::vec3> handle, glm::vec3 const& vec) const
+{
+	int loc = slotLocation_(handle.slot_);
+	if (loc != -1)
+		glUniform3fv(loc, 1, glm::value_ptr(vec));
 }
 
-void Shader::bind() const { glUseProgram(program_); }
+void Shader::set(UniformHandle<float> handle, float value) const
+{
+	int loc = slotLocation_(handle.slot_);
+	if (loc != -1)
+		glUniform1f(loc, value);
+}
 
-void Shader::unbind() const { glUseProgram(0); }
+void Shader::set(UniformHandle<int> handle, int value) const
+{
+	int loc = slotLocation_(handle.slot_);
+	if (loc != -1)
+		glUniform1i(loc, value);
+}
+
+void Shader::set(UniformHandle<bool> handle, bool value) const
+{
+	int loc = slotLocation_(handle.slot_);
+	if (loc != -1)
+		glUniform1i(loc, static_cast<int>(value));
+}
 
 void Shader::sendMat4(char const* name, glm::mat4 const& mat) const
 {
-	int loc = glGetUniformLocation(program_, name);
+	int loc = getUniformLocation(name);
 	if (loc != -1)
 		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
 }
 
 void Shader::sendVec3(char const* name, glm::vec3 const& vec) const
 {
-	int loc = glGetUniformLocation(program_, name);
+	int loc = getUniformLocation(name);
 	if (loc != -1)
 		glUniform3fv(loc, 1, glm::value_ptr(vec));
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
 }
 
 void Shader::sendFloat(char const* name, float value) const
 {
-	int loc = glGetUniformLocation(program_, name);
+	int loc = getUniformLocation(name);
 	if (loc != -1)
 		glUniform1f(loc, value);
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
 }
 
 void Shader::sendInt(char const* name, int value) const
 {
-	int loc = glGetUniformLocation(program_, name);
+	int loc = getUniformLocation(name);
 	if (loc != -1)
 		glUniform1i(loc, value);
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+}
+
+void Shader::sendBool(char const* name, bool value) const
+{
+	int loc = getUniformLocation(name);
+	if (loc != -1)
+		glUniform1i(loc, static_cast<int>(value));
 }
@@ -0,0 +1,53 @@
+#include "ShaderVariants.hpp"
+
+#include <iostream>
+#include <iterator>
+
+namespace {
+// Define names, in the bit order of ShaderFeature
+char const* const kFeatureNames[] = {"SKINNING", "DOUBLE_SIDED", "OVERLAY_TEXTURE", "INSTANCING"};
+} // namespace
+
+void ShaderVariants::resetShaderPath(std::string const& v, std::string const& f)
+{
+	vsPath_ = v;
+	fsPath_ = f;
+	variants_.clear();
+}
+
+void ShaderVariants::reload()
+{
+	for (auto& [features, shader] : variants_)
+		shader->reload();
+}
+
+Shader const& ShaderVariants::get(unsigned int features)
+{
+	auto it = variants_.find(features);
+	if (it != variants_.end())
+		return *it->second;
+
+	auto shader = std::make_unique<Shader>();
+	shader->resetShaderPath(vsPath_, fsPath_, getDefines(features));
+	for (auto const& [name, unit] : samplerUnits_)
+		shader->setSamplerUnit(name.c_str(), unit);
+	// std::cout << "[ShaderVariants INFO] Compiled '" << vsPath_ << "' with features " << features << std::endl;
+
+	return *variants_.emplace(features, std::move(shader)).first->second;
+}
+
+void ShaderVariants::setSamplerUnit(char const* name, int unit)
+{
+	samplerUnits_.emplace_back(name, unit);
+	for (auto& [features, shader] : variants_)
+		shader->setSamplerUnit(name, unit);
+}
+
+std::vector<std::string> ShaderVariants::getDefines(unsigned int features)
+{
+	std::vector<std::string> defines;
+	for (std::size_t i = 0; i < std::size(kFeatureNames); ++i)
+		if (features & (1u << i))
+			defines.emplace_back(kFeatureNames[i]);
+	return defines;
+}
@@ -0,0 +1,77 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "Skeleton.hpp"
+
+#include <iostream>
+
+#include "Node.hpp"
+#include "PosePool.hpp"
+
+void Skeleton::clear()
+{
+	parents_.clear();
+	order_.clear();
+}
+
+void Skeleton::build(std::vector<std::shared_ptr<Node>> const& nodes, std::shared_ptr<Node> const& root)
+{
+	clear();
+	parents_.assign(nodes.size(), -1);
+	if (!root || root->nodeNum < 0 || static_cast<std::size_t>(root->nodeNum) >= nodes.size())
+		return;
+
+	// Breadth-first from the root, a node is appended only after its parent so the order is topological
+	std::vector<bool> visited(nodes.size(), false);
+	order_.push_back(root->nodeNum);
+	visited[root->nodeNum] = true;
+
+	for (std::size_t i = 0; i < order_.size(); ++i) {
+		int parent = order_[i];
+		if (!nodes[parent])
+			continue;
+
+		for (auto const& child : nodes[parent]->children) {
+			if (!child || child->nodeNum < 0 || static_cast<std::size_t>(child->nodeNum) >= nodes.size() || visited[child->nodeNum])
+				continue; // Invalid or shared child, keep the first parent
+
+			visited[child->nodeNum] = true;
+			parents_[child->nodeNum] = parent;
+			order_.push_back(child->nodeNum);
+		}
+	}
+
+	// std::cout << "[Skeleton INFO] Flattened " << order_.size() << " of " << nodes.size() << " nodes" << std::endl;
+}
+
+glm::mat4x3 Skeleton::composeTRS(glm::vec3 const& translation, glm::quat const& rotation, glm::vec3 const& scale)
+{
+	// T * R * S without the constant bottom row
+	glm::mat3 r = glm::mat3_cast(rotation);
+	return glm::mat4x3(r[0] * scale.x, r[1] * scale.y, r[2] * scale.z, translation);
+}
+
+glm::mat4x3 Skeleton::multiplyAffine(glm::mat4x3 const& a, glm::mat4x3 const& b)
+{
+	glm::mat3 linear(a);
+	return glm::mat4x3(linear * b[0], linear * b[1], linear * b[2], linear * b[3] + a[3]);
+}
+
+std::size_t Skeleton::computeWorldMatrices(Pose& pose) const
+{
+	// Parents come first, so a changed parent has already flagged itself by the time its children are visited
+	std::size_t recomputed = 0;
+	for (int node : order_) {
+		if (static_cast<std::size_t>(node) >= pose.nodeCount)
+			continue;
+
+		int parent = parents_[node];
+		if (!pose.dirty[node] && (parent < 0 || !pose.dirty[parent]))
+			continue;
+
+		pose.dirty[node] = 1;
+		glm::mat4x3 local = composeTRS(pose.translations[node], pose.rotations[node], pose.scales[node]);
+		pose.worldMatrices[node] = parent < 0 ? local : multiplyAffine(pose.worldMatrices[parent], local);
+		++recomputed;
+	}
+	return recomputed;
+}
@@ -0,0 +1,62 @@
+#include "SkinnedVertexCache.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "AnimationKernels.hpp"
+#include "AnimationSystem.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "PosePool.hpp"
+
+bool SkinnedVertexCache::update(Model const& model, Pose const& pose, std::uint64_t poseVersion)
+{
+	if (valid_ && version_ == poseVersion)
+		return false;
+
+	meshOffsets_.resize(model.meshes.size());
+	std::size_t vertexCount = 0;
+	for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+		meshOffsets_[m] = vertexCount;
+		vertexCount += model.meshes[m].vertices.size();
+	}
+	positions_.resize(vertexCount);
+
+	// Chunks never span two meshes, so every job is one kernel call over one vertex array
+	struct Chunk {
+		Mesh const* mesh;
+		std::size_t begin, end;
+		glm::vec3* out;
+	};
+	std::vector<Chunk> chunks;
+	for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+		Mesh const& mesh = model.meshes[m];
+		for (std::size_t begin = 0; begin < mesh.vertices.size(); begin += kChunkSize)
+			chunks.push_back({&mesh, begin, std::min(begin + kChunkSize, mesh.vertices.size()), positions_.data() + meshOffsets_[m]});
+	}
+
+	auto skinChunk = [&](std::size_t index) {
+		Chunk const& chunk = chunks[index];
+		AnimationKernels::skinPositions(chunk.mesh->vertices.data(), chunk.begin, chunk.end, pose.jointMatrices, pose.jointCount, chunk.out);
+	};
+
+	if (chunks.size() > 1) {
+		AnimationSystem::getInstance().parallelFor(chunks.size(), skinChunk);
+	}
+	else if (!chunks.empty()) {
+		skinChunk(0);
+	}
+
+	version_ = poseVersion;
+	valid_ = true;
+	++skinCount_;
+	// std::cout << "[SkinnedVertexCache INFO] Skinned " << vertexCount << " vertices in " << chunks.size() << " chunks" << std::endl;
+	return true;
+}
+
+glm::vec3 const* SkinnedVertexCache::getPositions(std::size_t meshIndex) const
+{
+	if (!valid_ || meshIndex >= meshOffsets_.size())
+		return nullptr;
+	return positions_.data() + meshOffsets_[meshIndex];
+}
@@ -10,6 +10,7 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include "AnimationBenchmark.hpp"
 #include "CollisionSystem.hpp"
 #include "GlobalAnimationState.hpp"
 #include "ModelRegistry.hpp"
@@ -17,7 +18,9 @@
 #include "Scene.hpp"
 #include "include_5568ke.hpp"
 
+class Model;
 class Node;
+struct Pose;
 class Scene;
 class GameObject;
 
@@ -60,8 +63,13 @@ private:
 	int selectedGameObjectIndex_{};
 	int selectedClipIndex_{-1};
 
+	// Benchmark state
+	std::vector<AnimationBenchmark::ClipLookupResult> lookupBenchmarkResults_;
+	std::vector<AnimationBenchmark::SkinningResult> skinningBenchmarkResults_;
+
 	// Utility functions
 	void loadSelectedModel_(Scene& scene);
 	void drawTransformEditor_(GameObject& gameObject);
-	void drawNodeTree_(std::shared_ptr<Node> node, int depth);
+	void drawModelInfo_(Model const& model);
+	void drawNodeTree_(std::shared_ptr<Node> node, int depth, Pose const& pose);
 };
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <set>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -12,10 +13,16 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include "AnimationClip.hpp"
+#include "AnimationInstance.hpp"
+#include "AnimationSystem.hpp"
+#include "ClipResidency.hpp"
 #include "Collider.hpp"
+#include "GLState.hpp"
 #include "ImGuiFileDialog.h"
+#include "Mesh.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
+#include "ProgramCache.hpp"
 
 ImGuiManager& ImGuiManager::getInstance()
 {
@@ -124,6 +131,36 @@ void ImGuiManager::drawTransformEditor_(GameObject& gameObject)
 		gameObject.updateTransformMatrix();
 }
 
+void ImGuiManager::drawModelInfo_(Model const& model)
+{
+	ImGui::Text("Nodes: %zu, Meshes: %zu, Clips: %zu", model.nodes.size(), model.meshes.size(), model.animations.size());
+
+	// Animation memory per clip, before and after compression
+	std::size_t totalRaw = 0, totalCompressed = 0;
+	for (auto const& clip : model.animations) {
+		if (!clip->isCompressed()) {
+			ImGui::Text("%s: %.2f s, uncompressed (%zu channels)", clip->clipName.c_str(), clip->getDuration(), clip->getChannelCount());
+			continue;
+		}
+
+		CompressionReport const& report = clip->getCompressionReport();
+		ImGui::Text("%s: %.2f s, %.1f KB -> %.1f KB (%.1fx)", clip->clipName.c_str(), clip->getDuration(), report.rawBytes / 1024.0f,
+								report.compressedBytes / 1024.0f, report.getRatio());
+		ImGui::Text("  keys %zu -> %zu, tolerance %.4f", report.rawKeys, report.compressedKeys, report.tolerance);
+		totalRaw += report.rawBytes;
+		totalCompressed += report.compressedBytes;
+	}
+
+	if (totalCompressed > 0) {
+		// Shortfalls against the target show up here, lower tolerances and fully animated rigs compress less
+		float ratio = static_cast<float>(totalRaw) / totalCompressed;
+		ImVec4 color = ratio >= CompressedClip::kTargetRatio ? ImVec4(0.4f, 1.0f, 0.4f, 1.0f) : ImVec4(1.0f, 0.8f, 0.2f, 1.0f);
+		ImGui::Text("Total animation data: %.1f KB -> %.1f KB", totalRaw / 1024.0f, totalCompressed / 1024.0f);
+		ImGui::SameLine();
+		ImGui::TextColored(color, "(%.1fx, target %.0fx)", ratio, CompressedClip::kTargetRatio);
+	}
+}
+
 void ImGuiManager::drawModelLoaderInterface(Scene& scene)
 {
 	if (ImGui::Button("Load Model")) {
@@ -226,6 +263,9 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 		// Transform editor
 		if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
 			drawTransformEditor_(gameObject);
+
+		if (ImGui::CollapsingHeader("Model Info"))
+			drawModelInfo_(*gameObject.getModel());
 	}
 
 	// Show bone hierarchy
@@ -241,24 +281,14 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 				std::shared_ptr<Node> rootNode = gameObject.getModel()->rootNode;
 				ImGui::Text("Root node ID: %d, Name: %s", rootNode->nodeNum, rootNode->nodeName.empty() ? "<unnamed>" : rootNode->nodeName.c_str());
 
-				// Show full hierarchy starting at root
-				drawNodeTree_(rootNode, 0);
+				// Show full hierarchy starting at root, with the object's current pose
+				Pose const& pose = gameObject.hasAnimation() ? gameObject.getAnimation()->getPose() : gameObject.getModel()->bindPose.get();
+				drawNodeTree_(rootNode, 0, pose);
 
 				// If root node doesn't have all nodes as descendants,
-				// find potential other top-level nodes
-				std::set<int> processedNodes;
-				std::function<void(std::shared_ptr<Node>)> collectNodes = [&processedNodes, &collectNodes](std::shared_ptr<Node> node) {
-					if (!node)
-						return;
-
-					processedNodes.insert(node->nodeNum);
-					for (auto& child : node->children) {
-						collectNodes(child);
-					}
-				};
-
-				// Collect all nodes in the hierarchy
-				collectNodes(rootNode);
+				// find potential other top-level nodes, the flattened skeleton lists every node below the root
+				std::vector<int> const& order = gameObject.getModel()->skeleton.getOrder();
+				std::set<int> processedNodes(order.begin(), order.end());
 
 				// Check for disconnected nodes (not in the main hierarchy)
 				bool foundDisconnected = false;
@@ -272,7 +302,7 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 						}
 
 						// Show each disconnected node
-						drawNodeTree_(gameObject.getModel()->nodes[i], 0);
+						drawNodeTree_(gameObject.getModel()->nodes[i], 0, pose);
 					}
 				}
 			}
@@ -309,6 +339,13 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 		return;
 	}
 
+	if (!gameObject.hasAnimation()) {
+		ImGui::Text("Object has no animation instance");
+		ImGui::End();
+		return;
+	}
+	AnimationInstance& anim = *gameObject.getAnimation();
+
 	// Animation clips
 	std::vector<std::string> clipNames;
 	for (auto const& clip : gameObject.getModel()->animations)
@@ -323,14 +360,9 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 			if (ImGui::Selectable(clipNames[i].c_str(), isSelected)) {
 				selectedClipIndex_ = i;
 
-				// Update global animation state
-				animStateRef.clipIndex = selectedClipIndex_;
-
 				// Reset animation visually
-				if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-					model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-					model.updateLocalMatrices();
-				}
+				anim.pause();
+				anim.setFrame(selectedClipIndex_, 0.0f);
 			}
 			if (isSelected) {
 				ImGui::SetItemDefaultFocus();
@@ -346,9 +378,9 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 
 	// Speed control
 	{
-		float speed = animStateRef.getAnimateSpeed();
+		float speed = anim.getSpeed();
 		if (ImGui::SliderFloat("Speed", &speed, 0.1f, 2.0f)) {
-			animStateRef.setAnimateSpeed(speed);
+			anim.setSpeed(speed);
 		}
 	}
 
@@ -360,14 +392,11 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 
 	// Time slider
 	if (duration > 0.0f) {
-		float& currentTime = animStateRef.currentTime;
+		float currentTime = anim.getClipIndex() == selectedClipIndex_ ? anim.getTime() : 0.0f;
 
 		if (ImGui::SliderFloat("Time", &currentTime, 0.0f, duration)) {
-			// Update animation frame if this is the current gameObject
-			if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-				model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, currentTime);
-				model.updateLocalMatrices();
-			}
+			// Scrubbing poses the selected clip, playback continues from there
+			anim.setFrame(selectedClipIndex_, currentTime);
 		}
 	}
 
@@ -377,65 +406,145 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 	if (ImGui::Button("Play", ImVec2(60, 30))) {
 		// std::cout << "[ImGui] Play button pressed for " << animStateRef.gameObjectName << ", clip " << selectedClipIndex_ << std::endl;
 
-		// Start animation
-		animStateRef.play(selectedClipIndex_);
-
-		// Apply initial frame for visual feedback
-		if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-			model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-			model.updateLocalMatrices();
-		}
+		// Start animation, play() poses the first frame for visual feedback
+		anim.play(selectedClipIndex_);
 	}
 	ImGui::SameLine();
 
 	if (ImGui::Button("Pause", ImVec2(60, 30))) {
 		// std::cout << "[ImGui] Pause button pressed" << std::endl;
-		animStateRef.pause();
+		anim.pause();
 	}
 	ImGui::SameLine();
 
 	if (ImGui::Button("Resume", ImVec2(70, 30))) {
 		// std::cout << "[ImGui] Resume button pressed" << std::endl;
 
-		if (animStateRef.clipIndex != selectedClipIndex_) {
-			// If different gameObject/clip, start animation
-			animStateRef.play(selectedClipIndex_, animStateRef.currentTime);
+		if (anim.getClipIndex() != selectedClipIndex_) {
+			// If different clip, start animation
+			anim.play(selectedClipIndex_, anim.getTime());
 		}
 		else {
 			// Otherwise just resume
-			animStateRef.resume();
+			anim.resume();
 		}
 	}
 	ImGui::SameLine();
 
 	if (ImGui::Button("Stop", ImVec2(60, 30))) {
 		// std::cout << "[ImGui] Stop button pressed" << std::endl;
-		animStateRef.stop();
+		anim.stop(); // Resets to the bind pose
+	}
 
-		// Reset visually
-		if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-			model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-			model.updateLocalMatrices();
-		}
+	// Crossfade into the selected clip
+	ImGui::SliderFloat("Crossfade (s)", &animStateRef.crossfadeDuration, 0.0f, 1.0f, "%.2f");
+	if (ImGui::Button("Blend To", ImVec2(80, 30))) {
+		anim.crossfade(selectedClipIndex_, animStateRef.crossfadeDuration);
 	}
 
 	// Animation state display
-	ImGui::Text("Animation State: %s", animStateRef.isAnimating ? "Playing" : "Stopped");
+	ImGui::Text("Animation State: %s", anim.isPlaying() ? "Playing" : "Stopped");
+	if (anim.isCrossfading())
+		ImGui::Text("Crossfading: %.0f%%", anim.getCrossfadeWeight() * 100.0f);
 
-	if (animStateRef.isAnimating) {
-		ImGui::Text("Current Time: %.2f / %.2f", animStateRef.currentTime, duration);
+	if (anim.isPlaying()) {
+		ImGui::Text("Current Time: %.2f / %.2f", anim.getTime(), anim.getClipDuration());
 
 		// Progress bar
-		float progress = duration > 0.0f ? (animStateRef.currentTime / duration) : 0.0f;
+		float progress = anim.getClipDuration() > 0.0f ? (anim.getTime() / anim.getClipDuration()) : 0.0f;
 		std::string progressStr = std::to_string(static_cast<int>(progress * 100)) + "%";
 		ImGui::ProgressBar(progress, ImVec2(-1, 0), progressStr.c_str());
 	}
 
+	if (ImGui::CollapsingHeader("Baking")) {
+		ImGui::SliderFloat("Bake Rate (Hz)", &animStateRef.bakeSampleRate, 10.0f, 120.0f, "%.0f");
+		ImGui::Checkbox("Bake NPC Idle Clips", &animStateRef.bakeIdleClips);
+
+		if (ImGui::Button("Bake Clip"))
+			model.animations[selectedClipIndex_]->bake(animStateRef.bakeSampleRate);
+		ImGui::SameLine();
+		if (ImGui::Button("Bake All")) {
+			for (auto const& clip : model.animations)
+				clip->bake(animStateRef.bakeSampleRate);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Clear Bakes")) {
+			for (auto const& clip : model.animations)
+				clip->clearBake();
+		}
+
+		// Per-clip memory and accuracy of the baked tables
+		for (auto const& clip : model.animations) {
+			if (!clip->isResident()) {
+				ImGui::Text("%s: not resident", clip->clipName.c_str());
+				continue;
+			}
+			if (!clip->isBaked()) {
+				ImGui::Text("%s: keyframed", clip->clipName.c_str());
+				continue;
+			}
+
+			BakeReport const& report = clip->getBakeReport();
+			ImGui::Text("%s: %.0f Hz, %zu frames, %.1f KB", clip->clipName.c_str(), report.sampleRate, report.frameCount, report.bytes / 1024.0f);
+			ImGui::Text("  max error: rot %.3f deg | pos %.4f | scale %.4f", glm::degrees(report.maxRotationError), report.maxTranslationError,
+									report.maxScaleError);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Bounds")) {
+		ImGui::Checkbox("Precompute Clip Bounds", &animStateRef.precomputeClipBounds);
+		ImGui::SliderFloat("Sample Rate (Hz)", &animStateRef.clipBoundsSampleRate, 5.0f, 60.0f, "%.0f");
+		ImGui::SliderFloat("Padding", &animStateRef.clipBoundsPadding, 0.0f, 0.25f, "%.2f");
+		ImGui::TextDisabled("Applies to models loaded afterwards");
+		if (ImGui::Button("Compute For This Model"))
+			model.computeClipBounds(animStateRef.clipBoundsSampleRate, animStateRef.clipBoundsPadding);
+		ImGui::Text("Joint boxes: %zu, clip boxes: %zu", model.jointBounds.size(), model.clipBounds.size());
+	}
+
+	if (ImGui::CollapsingHeader("Clip Residency")) {
+		ImGui::SliderInt("Memory Budget (KB)", &animStateRef.clipMemoryBudgetKB, 0, 16384);
+		ImGui::SliderFloat("Evict After (s)", &animStateRef.clipEvictSeconds, 0.0f, 120.0f, "%.0f");
+		ImGui::TextDisabled("Applies to models loaded while lazy loading is on");
+		ImGui::Checkbox("Lazy Clip Loading", &animStateRef.lazyClips);
+
+		// Clips of this model, decoded data or the packed keyframes they are decoded from
+		for (auto const& clip : model.animations) {
+			if (clip->isResident())
+				ImGui::Text("%s: resident, %.1f KB", clip->clipName.c_str(), clip->getMemoryBytes() / 1024.0f);
+			else
+				ImGui::Text("%s: %s, %.1f KB packed", clip->clipName.c_str(),
+										clip->getResidency() == ClipResidencyState::DECODING ? "decoding" : "evicted", clip->getSourceBytes() / 1024.0f);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Benchmark")) {
+		if (ImGui::Button("Run Keyframe Lookup Benchmark")) {
+			lookupBenchmarkResults_ = AnimationBenchmark::runKeyframeLookup(scene);
+			AnimationBenchmark::printResults(lookupBenchmarkResults_);
+		}
+
+		for (auto const& r : lookupBenchmarkResults_) {
+			ImGui::Text("%s / %s (%zu %s, %zu keys)", r.modelName.c_str(), r.clipName.c_str(), r.channelCount, r.compressed ? "tracks" : "ch", r.keyCount);
+			ImGui::Text("  linear %.3f ms | binary %.3f ms | cursor %.3f ms", r.linearMs, r.binaryMs, r.cursorMs);
+		}
+
+		if (ImGui::Button("Run Skinning Benchmark")) {
+			skinningBenchmarkResults_ = AnimationBenchmark::runSkinning(scene);
+			AnimationBenchmark::printResults(skinningBenchmarkResults_);
+		}
+
+		for (auto const& r : skinningBenchmarkResults_) {
+			ImGui::Text("%s (%zu vertices, %zu joints)", r.modelName.c_str(), r.vertexCount, r.jointCount);
+			ImGui::Text("  Mvert/s/core: scalar %.1f | simd %.1f | parallel %.1f (%zu threads)", r.scalarRate() / 1e6, r.simdRate() / 1e6,
+									r.parallelRate() / 1e6, r.threadCount);
+		}
+	}
+
 	ImGui::End();
 }
 
 // Implement the node hierarchy display function
-void ImGuiManager::drawNodeTree_(std::shared_ptr<Node> node, int depth)
+void ImGuiManager::drawNodeTree_(std::shared_ptr<Node> node, int depth, Pose const& pose)
 {
 	if (!node) {
 		return;
@@ -445,8 +554,11 @@ void ImGuiManager::drawNodeTree_(std::shared_ptr<Node> node, int depth)
 	int nodeNum = node->nodeNum;
 	std::string nodeName = node->nodeName.empty() ? "Node_" + std::to_string(nodeNum) : node->nodeName;
 
+	// The node supplies names and children, the TRS shown is the pose's
+	bool posed = nodeNum >= 0 && static_cast<std::size_t>(nodeNum) < pose.nodeCount;
+
 	// Format position for display
-	glm::vec3 translation = node->translation;
+	glm::vec3 translation = posed ? pose.translations[nodeNum] : node->translation;
 	std::string posStr = "(" + std::to_string(translation.x).substr(0, 5) + ", " + std::to_string(translation.y).substr(0, 5) + ", " +
 											 std::to_string(translation.z).substr(0, 5) + ")";
 
@@ -482,11 +594,11 @@ void ImGuiManager::drawNodeTree_(std::shared_ptr<Node> node, int depth)
 		ImGui::Indent();
 
 		// Show rotation
-		glm::quat rotation = node->rotation;
+		glm::quat rotation = posed ? pose.rotations[nodeNum] : node->rotation;
 		ImGui::Text("Rotation: (w=%.2f, x=%.2f, y=%.2f, z=%.2f)", rotation.w, rotation.x, rotation.y, rotation.z);
 
 		// Show scale
-		glm::vec3 scale = node->scale;
+		glm::vec3 scale = posed ? pose.scales[nodeNum] : node->scale;
 		ImGui::Text("Scale: (%.2f, %.2f, %.2f)", scale.x, scale.y, scale.z);
 
 		// Show child count
@@ -495,7 +607,7 @@ void ImGuiManager::drawNodeTree_(std::shared_ptr<Node> node, int depth)
 
 		// Process all children
 		for (auto const& child : node->children) {
-			drawNodeTree_(child, depth + 1);
+			drawNodeTree_(child, depth + 1, pose);
 		}
 
 		ImGui::Unindent();
@@ -515,8 +627,51 @@ void ImGuiManager::drawStatusWindow(Scene& scene)
 	ImGui::Text("F1-F4 to toggle UI windows");
 
 	// Show animation state if active
-	if (animStateRef.isAnimating)
-		ImGui::Text("Animating: %s (clip %d, time %.2f)", animStateRef.gameObjectName.c_str(), animStateRef.clipIndex, animStateRef.currentTime);
+	std::size_t playing = 0;
+	for (auto const& goPtr : scene.gameObjects) {
+		if (goPtr && goPtr->hasAnimation() && goPtr->getAnimation()->isPlaying())
+			++playing;
+	}
+	ImGui::Text("Animating: %zu objects, %zu pooled poses", playing, PosePool::getInstance().getBlocksInUse());
+	DedupStats const& dedup = registryRef.getDedupStats();
+	ImGui::Text("Shared at load: %zu rigs, %zu clips, %.1f KB deduplicated", dedup.sharedRigs, dedup.sharedClips, dedup.bytesSaved / 1024.0);
+	AnimationSystem const& animationSystem = AnimationSystem::getInstance();
+	ImGui::Text("Recomputed: %zu nodes, %zu joints", animationSystem.getStats().nodesRecomputed, animationSystem.getStats().jointsRecomputed);
+	ImGui::Text("Animation update: %.3f ms, %zu jobs on %zu workers + main", animationSystem.getLastUpdateMs(), animationSystem.getJobCount(),
+							animationSystem.getWorkerCount());
+	ImGui::Text("Animation LOD: %zu full, %zu reduced, %zu offscreen", animationSystem.getTierCount(AnimationLOD::FULL),
+							animationSystem.getTierCount(AnimationLOD::REDUCED), animationSystem.getTierCount(AnimationLOD::OFFSCREEN));
+	// GPU vertex memory of the models in the scene against the unpacked Vertex layout
+	std::set<Model const*> models;
+	std::size_t vertexBytes = 0, unpackedBytes = 0;
+	for (auto const& goPtr : scene.gameObjects) {
+		if (!goPtr || !goPtr->getModel() || !models.insert(goPtr->getModel().get()).second)
+			continue;
+		for (auto const& mesh : goPtr->getModel()->meshes) {
+			vertexBytes += mesh.getVertexBytes();
+			unpackedBytes += mesh.vertices.size() * sizeof(Vertex);
+		}
+	}
+	ImGui::Text("Vertex buffers: %.1f KB packed (%.1f KB unpacked)", vertexBytes / 1024.0, unpackedBytes / 1024.0);
+	for (auto const& [name, report] : registryRef.getMeshReports()) {
+		ImGui::Text("  %s: ACMR %.2f -> %.2f, indices %.1f -> %.1f KB, vertices %zu -> %zu", name.c_str(), report.acmrBefore(), report.acmrAfter(),
+								report.indexBytesBefore / 1024.0, report.indexBytesAfter / 1024.0, report.verticesBefore, report.verticesAfter);
+	}
+
+	Renderer::FrameStats const& frame = rendererRef.getFrameStats();
+	ImGui::Text("Draws: %d calls for %d objects, %d instanced (%d instances)", frame.drawCalls, frame.visibleEntities, frame.instancedDraws,
+							frame.instances);
+	ImGui::Text("Culled: %d objects, %d meshes, %d clusters", frame.culledObjects, frame.culledMeshes, frame.culledClusters);
+
+	GLStateCounters const& glCalls = GLState::getInstance().getLastFrameCounters();
+	ImGui::Text("GL state calls: %zu issued, %zu skipped as redundant", glCalls.issued, glCalls.skipped);
+	ProgramCacheStats const& programs = ProgramCache::getInstance().getStats();
+	ImGui::Text("Shader programs: %zu from cache, %zu compiled, %zu rejected, %.1f ms", programs.cachedPrograms, programs.compiledPrograms,
+							programs.rejectedBinaries, programs.programMs);
+
+	ClipResidencyStats const& residency = ClipResidency::getInstance().getStats();
+	ImGui::Text("Clips: %zu / %zu resident (%.1f KB), %zu decoding, %zu evicted so far", residency.residentClips, residency.trackedClips,
+							residency.residentBytes / 1024.0, residency.decodingClips, residency.evictions);
 
 	ImGui::End();
 }
@@ -557,6 +712,9 @@ void ImGuiManager::drawSceneControlWindow(Scene& scene)
 
 							ImGui::Separator();
 
+	ImGui::Checkbox("Frustum Culling", &rendererRef.frustumCulling);
+	ImGui::Checkbox("Instancing", &rendererRef.instancing);
+
 	// Camera section
 	if (ImGui::CollapsingHeader("Camera Controls", ImGuiTreeNodeFlags_DefaultOpen)) {
 		// Camera position
@@ -594,6 +752,15 @@ void ImGuiManager::drawSceneControlWindow(Scene& scene)
 		}
 	}
 
+	// Animation level of detail
+	if (ImGui::CollapsingHeader("Animation LOD")) {
+		ImGui::Checkbox("Enable Animation LOD", &animStateRef.lodEnabled);
+		ImGui::SliderFloat("Reduced Distance", &animStateRef.lodReducedDistance, 1.0f, 100.0f);
+		ImGui::SliderInt("Reduced Interval", &animStateRef.lodReducedInterval, 1, 8);
+		ImGui::SliderInt("Offscreen Interval", &animStateRef.lodOffscreenInterval, 0, 30);
+		ImGui::TextDisabled("Offscreen interval 0 pauses characters out of view");
+	}
+
 	// Lighting section
 	if (ImGui::CollapsingHeader("Lighting Controls", ImGuiTreeNodeFlags_DefaultOpen)) {
 		for (size_t i = 0; i < scene.lights.size(); i++) {
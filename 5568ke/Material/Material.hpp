@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <vector>
 
@@ -11,4 +13,11 @@ enum class MaterialType { BlinnPhong, PBR };
 class Material {
 public:
 	virtual void bind(Shader const& shader) const = 0;
+	virtual unsigned int getShaderFeatures() const { return 0; } // ShaderFeature keys the material needs, see ShaderVariants
+
+	std::uint32_t getSortId() const { return sortId_; } // Groups the draws of a material in the RenderQueue, never 0
+
+private:
+	inline static std::atomic<std::uint32_t> nextSortId_{1};
+	std::uint32_t sortId_{nextSortId_.fetch_add(1, std::memory_order_relaxed)};
 };
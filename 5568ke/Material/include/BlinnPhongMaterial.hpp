@@ -12,4 +12,5 @@ public:
 	Texture* overlayMap{nullptr};
 
 	void bind(Shader const& shader) const override;
+	unsigned int getShaderFeatures() const override;
 };
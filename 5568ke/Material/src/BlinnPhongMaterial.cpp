@@ -1,25 +1,29 @@
 #include "BlinnPhongMaterial.hpp"
+#include "GLState.hpp"
+#include "ShaderVariants.hpp"
 #include "Texture.hpp"
 #include "include_5568ke.hpp"
 
-void BlinnPhongMaterial::bind(Shader const& shader) const
+unsigned int BlinnPhongMaterial::getShaderFeatures() const
+{
+	// Only materials with an overlay sample the second texture
+	return overlayMap ? SHADER_OVERLAY_TEXTURE : 0u;
+}
+
+void BlinnPhongMaterial::bind(Shader const&) const
 {
 	// The shader doesn't have material.albedo or material.shininess uniforms
-	// It directly uses the texture colors instead
+	// It directly uses the texture colors instead. Its samplers read fixed units (tex0 -> 0, tex1 -> 1, see
+	// Shader::setSamplerUnit), so only the textures are bound here, and only when they change
+	GLState& state = GLState::getInstance();
 
 	// Bind diffuse/base texture to texture unit 0
-	if (diffuseMap) {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap->id);
-		shader.sendInt("tex0", 0);
-	}
+	if (diffuseMap)
+		state.bindTexture(0, GL_TEXTURE_2D, diffuseMap->id);
 
 	// Bind overlay texture to texture unit 1
-	if (overlayMap) {
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, overlayMap->id);
-		shader.sendInt("tex1", 1);
-	}
+	if (overlayMap)
+		state.bindTexture(1, GL_TEXTURE_2D, overlayMap->id);
 
 	// If no textures are available, we could potentially add a fallback
 	// by modifying the shader to use a uniform color, but that would require
@@ -32,14 +36,12 @@ void BlinnPhongMaterial::bind(Shader const& shader) const
 			// Create a default white texture
 			unsigned char whitePixel[4] = {255, 255, 255, 255};
 			glGenTextures(1, &defaultTexture);
-			glBindTexture(GL_TEXTURE_2D, defaultTexture);
+			state.bindTexture(0, GL_TEXTURE_2D, defaultTexture);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, defaultTexture);
-		shader.sendInt("tex0", 0);
+		state.bindTexture(0, GL_TEXTURE_2D, defaultTexture);
 	}
 }
@@ -20,7 +20,7 @@ ModelRegistry& ModelRegistry::getInstance()
 }
 
 // Constructor/Destructor
-ModelRegistry::ModelRegistry() : gltfLoader_(std::make_unique<GltfLoader>()) {}
+ModelRegistry::ModelRegistry() : gltfLoader_(std::make_unique<GltfLoader>(&rigStore_)) {}
 
 // Load a model with optional position parameters
 std::shared_ptr<Model> ModelRegistry::loadModel(std::string const& path, std::string const& name)
@@ -57,7 +57,13 @@ std::shared_ptr<Model> ModelRegistry::loadModel(std::string const& path, std::st
 		model->modelName = modelName;
 		model->updateLocalMatrices();
 
+		MeshOptimizer::Report const& report = gltfLoader_->getLastMeshReport();
+		meshReports_.emplace_back(modelName, report);
+		// std::cout << "[ModelRegistry INFO] '" << modelName << "' ACMR " << report.acmrBefore() << " -> " << report.acmrAfter() << ", index buffer "
+		// << report.indexBytesBefore << " -> " << report.indexBytesAfter << " bytes" << std::endl;
+
 		// std::cout << "[ModelRegistry] Successfully loaded model '" << modelName << "'" << std::endl;
+		// std::cout << "[ModelRegistry INFO] " << rigStore_.getStats().bytesSaved << " bytes deduplicated so far" << std::endl;
 		return model;
 	}
 
@@ -7,6 +7,8 @@
 
 #include <glm/glm.hpp>
 
+#include "MeshOptimizer.hpp"
+#include "RigStore.hpp"
 #include "Scene.hpp"
 
 // Forward declarations
@@ -36,6 +38,12 @@ public:
 	// Remove a model from a scene
 	void removeModelFromScene(Scene& scene, std::string const& name);
 
+	// Skins and clips shared between models of the same rig
+	DedupStats const& getDedupStats() const { return rigStore_.getStats(); }
+
+	// Mesh optimization of every model loaded so far, by model name
+	std::vector<std::pair<std::string, MeshOptimizer::Report>> const& getMeshReports() const { return meshReports_; }
+
 public:
 	Scene& sceneRef = Scene::getInstance();
 
@@ -46,6 +54,9 @@ private:
 	// Detect format from file extension
 	ModelFormat detectFormat_(std::string const& path);
 
+	RigStore rigStore_;
+	std::vector<std::pair<std::string, MeshOptimizer::Report>> meshReports_;
+
 	// Concrete loader instances
 	std::unique_ptr<GltfLoader> gltfLoader_;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <tiny_gltf.h>
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
@@ -8,20 +9,29 @@
 
 #include "BoundingBox.hpp"
 #include "Material.hpp"
+#include "MeshOptimizer.hpp"
 #include "Texture.hpp"
 
 class Model;
 class Node;
 class Mesh;
+class RigStore;
 
 class GltfLoader {
 public:
-	GltfLoader() = default;
+	// Skins and clips are interned in 'rigStore' when given, so models sharing a rig share them
+	explicit GltfLoader(RigStore* rigStore = nullptr) : rigStore_(rigStore) {}
 	~GltfLoader() = default;
 
 	// Main loading method
 	std::shared_ptr<Model> loadModel(std::string const& path);
 
+	// Static primitives larger than this many triangles are split into spatial clusters for culling, 0 keeps them whole
+	std::size_t clusterTriangles{MeshOptimizer::kClusterTriangles};
+
+	// Mesh optimization of the last loaded model, summed over its meshes
+	MeshOptimizer::Report const& getLastMeshReport() const { return lastMeshReport_; }
+
 private:
 	// Main GLTF loading implementation
 	std::shared_ptr<Model> loadGltf_(std::string const& path, MaterialType type = MaterialType::BlinnPhong);
@@ -34,8 +44,11 @@ private:
 	// Animation loading methods
 	void loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
 	void loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
-	void processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex, glm::mat4 const& parentMatrix);
+	void processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex);
 
 	// Skin and animation data loading
 	void loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
+
+	RigStore* rigStore_{};
+	MeshOptimizer::Report lastMeshReport_{};
 };
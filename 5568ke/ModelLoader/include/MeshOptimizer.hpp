@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+class Mesh;
+
+/**
+ * @brief Load-time reordering of a mesh's vertices and triangles for the GPU, run before Mesh::setup.
+ *
+ */
+namespace MeshOptimizer {
+
+constexpr std::size_t kCacheSize = 32;					// LRU size the triangle order is optimized for
+constexpr std::size_t kMeasureCacheSize = 16;		// FIFO size ACMR is measured with
+constexpr std::size_t kClusterTriangles = 4096; // Largest cluster clusterPrimitives() leaves
+
+/**
+ * @brief Before and after of one mesh or, summed, of a whole asset.
+ *
+ */
+struct Report {
+	std::size_t verticesBefore{};
+	std::size_t verticesAfter{};
+	std::size_t triangles{};
+	std::size_t transformsBefore{}; // Vertex shader invocations with a kMeasureCacheSize FIFO cache
+	std::size_t transformsAfter{};
+	std::size_t indexBytesBefore{};
+	std::size_t indexBytesAfter{}; // Filled in once Mesh::setup has laid out the index buffer
+
+	float acmrBefore() const { return triangles ? static_cast<float>(transformsBefore) / triangles : 0.0f; } // Average cache miss ratio
+	float acmrAfter() const { return triangles ? static_cast<float>(transformsAfter) / triangles : 0.0f; }
+	Report& operator+=(Report const& other);
+};
+
+// Welds identical vertices, reorders every primitive's triangles for the vertex cache and then for overdraw, and finally
+// reorders the vertices in the order the triangles first use them. Primitives keep their index ranges and materials
+Report optimize(Mesh& mesh);
+
+// Splits every primitive with more than 'maxTriangles' triangles into spatially compact primitives of at most that many,
+// by recursive median splits of the triangle centroids. Each cluster keeps the material and is culled on its own, so
+// large static meshes (e.g. a room) are only partly drawn when the camera sees part of them. Returns the clusters added.
+// Run before optimize(), which then reorders each cluster for the vertex cache
+std::size_t clusterPrimitives(Mesh& mesh, std::size_t maxTriangles = kClusterTriangles);
+
+// Vertex shader invocations of drawing 'mesh' with a FIFO post-transform cache of 'cacheSize' entries
+std::size_t countTransforms(Mesh const& mesh, std::size_t cacheSize = kMeasureCacheSize);
+
+} // namespace MeshOptimizer
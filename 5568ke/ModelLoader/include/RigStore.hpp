@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class AnimationClip;
+struct Rig;
+
+/**
+ * @brief Totals of what the RigStore handed out again instead of keeping another copy.
+ *
+ */
+struct DedupStats {
+	std::size_t sharedRigs{};
+	std::size_t sharedClips{};
+	std::size_t bytesSaved{};
+};
+
+/**
+ * @brief Skins and animation clips interned by content. Entries are weak, the data lives as long as a model uses it.
+ * Lookups are keyed by signatures computed by the loader, so a matching clip is found before it is decoded. A clip keeps
+ * the data its key was hashed from, a match is only shared once that data compares equal too.
+ */
+class RigStore {
+public:
+	// Returns the stored rig with the same signature and skin, or stores and returns 'rig'
+	std::shared_ptr<Rig const> internRig(std::shared_ptr<Rig const> rig);
+
+	// 'data' are the bytes 'key' was hashed from
+	std::shared_ptr<AnimationClip> findClip(std::uint64_t key, std::vector<unsigned char> const& data);
+	void addClip(std::uint64_t key, std::shared_ptr<AnimationClip> const& clip, std::vector<unsigned char> data);
+
+	DedupStats const& getStats() const { return stats_; }
+
+private:
+	struct ClipEntry {
+		std::weak_ptr<AnimationClip> clip;
+		std::vector<unsigned char> data;
+	};
+
+	std::unordered_map<std::uint64_t, std::weak_ptr<Rig const>> rigs_;
+	std::unordered_map<std::uint64_t, ClipEntry> clips_;
+	DedupStats stats_{};
+};
@@ -2,21 +2,134 @@
 
 #include "GltfLoader.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <iostream>
+#include <utility>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include "AnimationClip.hpp"
 #include "BlinnPhongMaterial.hpp"
+#include "GlobalAnimationState.hpp"
+#include "Hash.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
+#include "MeshOptimizer.hpp"
 #include "Primitive.hpp"
+#include "RigStore.hpp"
 #include "Vertex.hpp"
 
+namespace {
+
+void appendBytes(std::vector<unsigned char>& data, void const* bytes, std::size_t size)
+{
+	unsigned char const* begin = static_cast<unsigned char const*>(bytes);
+	data.insert(data.end(), begin, begin + size);
+}
+
+template <typename T> void appendValue(std::vector<unsigned char>& data, T const& value) { appendBytes(data, &value, sizeof(T)); }
+
+// Raw bytes of an accessor, tightly packed or not, as they sit in the buffer
+void appendAccessor(std::vector<unsigned char>& data, tinygltf::Model const& gltfModel, int accessorIndex)
+{
+	if (accessorIndex < 0 || static_cast<std::size_t>(accessorIndex) >= gltfModel.accessors.size())
+		return;
+
+	tinygltf::Accessor const& accessor = gltfModel.accessors[accessorIndex];
+	if (accessor.bufferView < 0)
+		return;
+	tinygltf::BufferView const& bufferView = gltfModel.bufferViews[accessor.bufferView];
+	tinygltf::Buffer const& buffer = gltfModel.buffers[bufferView.buffer];
+
+	int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	int componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+	if (componentSize <= 0 || componentCount <= 0)
+		return;
+
+	std::size_t elementSize = static_cast<std::size_t>(componentSize * componentCount);
+	std::size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+	std::size_t begin = bufferView.byteOffset + accessor.byteOffset;
+	std::size_t size = accessor.count > 0 ? (accessor.count - 1) * stride + elementSize : 0;
+	if (begin + size > buffer.data.size())
+		return;
+
+	appendValue(data, accessor.count);
+	appendBytes(data, buffer.data.data() + begin, size);
+}
+
+// Joint names, parents and bind pose TRS from the file, plus the inverse bind matrices already read into 'rig'
+std::uint64_t computeRigSignature(tinygltf::Model const& gltfModel, Rig const& rig)
+{
+	std::vector<int> parents(gltfModel.nodes.size(), -1);
+	for (std::size_t i = 0; i < gltfModel.nodes.size(); ++i) {
+		for (int child : gltfModel.nodes[i].children) {
+			if (child >= 0 && static_cast<std::size_t>(child) < parents.size())
+				parents[child] = static_cast<int>(i);
+		}
+	}
+
+	std::uint64_t hash = Hash::hashValue(Hash::kSeed, rig.jointNodes.size());
+	for (int node : rig.jointNodes) {
+		if (node < 0 || static_cast<std::size_t>(node) >= gltfModel.nodes.size())
+			continue;
+
+		tinygltf::Node const& gltfNode = gltfModel.nodes[node];
+		hash = Hash::hashValue(hash, node);
+		hash = Hash::hashBytes(hash, gltfNode.name.data(), gltfNode.name.size());
+		hash = Hash::hashValue(hash, parents[node]);
+		for (auto const* values : {&gltfNode.translation, &gltfNode.rotation, &gltfNode.scale, &gltfNode.matrix})
+			hash = Hash::hashBytes(hash, values->data(), values->size() * sizeof(double));
+	}
+	return Hash::hashBytes(hash, rig.inverseBindMatrices.data(), rig.inverseBindMatrices.size() * sizeof(glm::mat4));
+}
+
+// Identifies a clip on a given rig: the keyframes and everything else the decoded clip depends on. Targets outside the rig
+// (e.g. an armature node above the root joint) are identified by name and rest pose
+std::vector<unsigned char> collectClipData(tinygltf::Model const& gltfModel, tinygltf::Animation const& anim, std::string const& clipName, Model const& model)
+{
+	GlobalAnimationState const& animState = GlobalAnimationState::getInstance();
+	std::vector<unsigned char> data;
+	appendValue(data, model.rig->signature);
+	appendValue(data, clipName.size());
+	appendBytes(data, clipName.data(), clipName.size());
+	appendValue(data, animState.compressClips);
+	appendValue(data, animState.compressionTolerance);
+
+	for (auto const& channel : anim.channels) {
+		if (channel.target_node < 0 || static_cast<std::size_t>(channel.target_node) >= gltfModel.nodes.size())
+			continue;
+		if (channel.sampler < 0 || static_cast<std::size_t>(channel.sampler) >= anim.samplers.size())
+			continue;
+
+		appendValue(data, channel.target_node);
+		bool isJoint = static_cast<std::size_t>(channel.target_node) < model.nodeToJointMapping.size() && model.nodeToJointMapping[channel.target_node] >= 0;
+		if (!isJoint) {
+			tinygltf::Node const& target = gltfModel.nodes[channel.target_node];
+			appendValue(data, target.name.size());
+			appendBytes(data, target.name.data(), target.name.size());
+			for (auto const* values : {&target.translation, &target.rotation, &target.scale, &target.matrix}) {
+				appendValue(data, values->size());
+				appendBytes(data, values->data(), values->size() * sizeof(double));
+			}
+		}
+
+		tinygltf::AnimationSampler const& sampler = anim.samplers[channel.sampler];
+		appendValue(data, channel.target_path.size());
+		appendBytes(data, channel.target_path.data(), channel.target_path.size());
+		appendValue(data, sampler.interpolation.size());
+		appendBytes(data, sampler.interpolation.data(), sampler.interpolation.size());
+		appendAccessor(data, gltfModel, sampler.input);
+		appendAccessor(data, gltfModel, sampler.output);
+	}
+	return data;
+}
+
+} // namespace
+
 std::shared_ptr<Model> GltfLoader::loadModel(std::string const& path) { return loadGltf_(path, MaterialType::BlinnPhong); }
 
 std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialType type)
@@ -73,12 +186,23 @@ std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialTy
 	// << gltfModel.audioSources.size() << " audioSources\n";
 
 	// Process all meshes in the GLTF file
+	lastMeshReport_ = MeshOptimizer::Report{};
 	for (tinygltf::Mesh& mesh : gltfModel.meshes) {
 		Mesh outMesh;
 		processMesh_(gltfModel, mesh, outMesh, type);
 
+		// Large static primitives become clusters that are culled on their own, skinned vertices move so their bounds would not hold
+		bool skinned = std::any_of(outMesh.vertices.begin(), outMesh.vertices.end(), [](Vertex const& v) { return v.boneWeights != glm::vec4(0.0f); });
+		if (!skinned)
+			MeshOptimizer::clusterPrimitives(outMesh, clusterTriangles);
+
+		// Weld and reorder for the GPU before the buffers are built
+		MeshOptimizer::Report report = MeshOptimizer::optimize(outMesh);
+
 		// Setup OpenGL buffers and VAO
 		outMesh.setup();
+		report.indexBytesAfter = outMesh.getIndexBytes();
+		lastMeshReport_ += report;
 
 		// Calculate bounding box
 		BoundingBox bbox = BBoxUtil::getMeshBBox(outMesh);
@@ -108,20 +232,20 @@ std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialTy
 	// Load animations if available
 	if (!gltfModel.animations.empty()) {
 		loadAnimations_(model, gltfModel);
-		model->updateLocalMatrices();
 		// std::cout << "[GltfLoader INFO] Loaded " << model->animations.size() << " animation clips" << std::endl;
 	}
 
-	if (model->rootNode) {
-		// Calculate all node matrices starting from the root
-		NodeUtil::updateNodeTreeMatricesRecursive(model->rootNode, glm::mat4(1.0f));
-		// std::cout << "[GltfLoader] Node matrices calculated for static transforms" << std::endl;
-	}
+	// Per-joint boxes, animated bounds are then these boxes moved by the joint matrices
+	if (model->jointCount > 0)
+		BBoxUtil::computeJointBounds(*model);
 
-	// Calculate global bounding box and store on the model
-	if (!model->boundingBoxes.empty()) {
-		BBoxUtil::updateLocalBBox(*model);
+	// Flatten the node tree and compose the bind pose, this also calculates the global bounding box and stores it on the model
+	model->updateLocalMatrices();
 
+	GlobalAnimationState const& animState = GlobalAnimationState::getInstance();
+	if (animState.precomputeClipBounds && !model->animations.empty())
+		model->computeClipBounds(animState.clipBoundsSampleRate, animState.clipBoundsPadding);
+	if (!model->boundingBoxes.empty()) {
 		// Print global bounding box info
 		// std::cout << "[GltfLoader INFO] Model global bounding box: min(" << model->localSpaceBBox.min.x << ", " << model->localSpaceBBox.min.y << ", "
 		// << model->localSpaceBBox.min.z << "), max(" << model->localSpaceBBox.max.x << ", " << model->localSpaceBBox.max.y << ", " << model->localSpaceBBox.max.z
@@ -436,6 +560,31 @@ void GltfLoader::loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model c
 		std::string clipName = anim.name.empty() ? "Animation_" + std::to_string(animIndex) : anim.name;
 		// std::cout << "[GltfLoader INFO] Creating animation clip: " << clipName << std::endl;
 
+		// Another model on the same rig may already have loaded this clip
+		std::vector<unsigned char> clipData;
+		std::uint64_t clipKey = 0;
+		if (rigStore_ && model->rig) {
+			clipData = collectClipData(gltfModel, anim, clipName, *model);
+			clipKey = Hash::hashBytes(Hash::kSeed, clipData.data(), clipData.size());
+		}
+		if (clipKey != 0) {
+			if (auto shared = rigStore_->findClip(clipKey, clipData)) {
+				model->animations.push_back(shared);
+				continue;
+			}
+		}
+
+		// Lazy clips keep only their packed keyframes and decode on first use
+		GlobalAnimationState const& animState = GlobalAnimationState::getInstance();
+		if (animState.lazyClips) {
+			if (auto clip = AnimationClip::createLazy(clipName, gltfModel, anim, model->nodes, animState.compressClips, animState.compressionTolerance)) {
+				model->animations.push_back(clip);
+				if (clipKey != 0)
+					rigStore_->addClip(clipKey, clip, std::move(clipData));
+			}
+			continue;
+		}
+
 		auto clip = std::make_shared<AnimationClip>(clipName);
 
 		// std::cout << "[GltfLoader INFO] Loading animation '" << clipName << "' with " << anim.channels.size() << " channels" << std::endl;
@@ -470,8 +619,14 @@ void GltfLoader::loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model c
 
 		// Only add the clip if it has valid channels
 		if (clip->getDuration() > 0) {
+			if (animState.compressClips)
+				clip->compress(model->nodes, animState.compressionTolerance);
+			else
+				clip->compile();
 			// std::cout << "[GltfLoader INFO] Animation '" << clipName << "' has duration: " << clip->getDuration() << std::endl;
 			model->animations.push_back(clip);
+			if (clipKey != 0)
+				rigStore_->addClip(clipKey, clip, std::move(clipData));
 		}
 		else {
 			// std::cout << "[GltfLoader INFO] Skipping animation '" << clipName << "' with zero duration" << std::endl;
@@ -517,7 +672,7 @@ void GltfLoader::loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Mode
 
 		// Process the entire node hierarchy starting from the root
 		// std::cout << "[GltfLoader INFO] Processing node hierarchy starting from root" << std::endl;
-		processNodeTreeRecursive_(model, gltfModel, rootNodeIndex, glm::mat4(1.0f));
+		processNodeTreeRecursive_(model, gltfModel, rootNodeIndex);
 
 		// std::cout << "[GltfLoader INFO] Node hierarchy loaded successfully" << std::endl;
 	} catch (std::exception const& e) {
@@ -527,7 +682,7 @@ void GltfLoader::loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Mode
 	}
 }
 
-void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex, glm::mat4 const& parentMatrix)
+void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex)
 {
 	// std::cout << "[GltfLoader INFO] Processing node " << nodeIndex << std::endl;
 
@@ -617,11 +772,7 @@ void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinyglt
 	}
 
 	try {
-		// Calculate matrices
-		currentNode->updateLocalTRSMatrix();
-		currentNode->updateNodeMatrix(parentMatrix);
-
-		// Process child nodes
+		// Process child nodes, matrices are computed later on the flattened skeleton (see Model::updateLocalMatrices)
 		// std::cout << "[GltfLoader INFO] Node " << nodeIndex << " has " << node.children.size() << " children" << std::endl;
 		for (size_t i = 0; i < node.children.size(); i++) {
 			int childIndex = node.children[i];
@@ -653,7 +804,7 @@ void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinyglt
 			currentNode->children.push_back(childNode);
 
 			// Recursively process child node
-			processNodeTreeRecursive_(model, gltfModel, childIndex, currentNode->getNodeMatrix());
+			processNodeTreeRecursive_(model, gltfModel, childIndex);
 		}
 	} catch (std::exception const& e) {
 		// std::cout << "[GltfLoader ERROR] Exception while processing node " << nodeIndex << ": " << e.what() << std::endl;
@@ -667,6 +818,9 @@ void GltfLoader::loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model con
 	// Process only the first skin for simplicity
 	tinygltf::Skin const& skin = gltfModel.skins[0];
 
+	auto rig = std::make_shared<Rig>();
+	rig->jointNodes = skin.joints;
+
 	// Load inverse bind matrices
 	// Note: skinnedPosition = jointMatrix * inverseBindMatrix * vertexPosition;
 	if (skin.inverseBindMatrices >= 0) {
@@ -675,16 +829,20 @@ void GltfLoader::loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model con
 		tinygltf::Buffer const& buffer = gltfModel.buffers[bufferView.buffer];
 
 		size_t numMatrices = accessor.count;
-		model->inverseBindMatrices.resize(numMatrices);
+		rig->inverseBindMatrices.resize(numMatrices);
 
 		float const* data = reinterpret_cast<float const*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
 		for (size_t i = 0; i < numMatrices; i++) {
-			model->inverseBindMatrices[i] = glm::make_mat4(data + i * 16);
+			rig->inverseBindMatrices[i] = glm::make_mat4(data + i * 16);
 		}
 
 		// std::cout << "[GltfLoader INFO] Loaded " << numMatrices << " inverse bind matrices" << std::endl;
 	}
 
+	// Models loaded earlier with the same rig keep the only copy
+	rig->signature = computeRigSignature(gltfModel, *rig);
+	model->rig = rigStore_ ? rigStore_->internRig(rig) : rig;
+
 	// Create joint mapping
 	model->nodeToJointMapping.resize(gltfModel.nodes.size(), -1);
 	for (size_t i = 0; i < skin.joints.size(); i++) {
@@ -692,63 +850,6 @@ void GltfLoader::loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model con
 		model->nodeToJointMapping[nodeIndex] = static_cast<int>(i);
 	}
 
-	// Initialize joint matrices with identity matrices
-	model->jointMatrices.resize(skin.joints.size(), glm::mat4(1.0f));
-
-	// Load vertex joint and weight data
-	if (!gltfModel.meshes.empty() && !gltfModel.meshes[0].primitives.empty()) {
-		tinygltf::Primitive const& primitive = gltfModel.meshes[0].primitives[0];
-
-		auto jointsIt = primitive.attributes.find("JOINTS_0");	 // which bones this vertex is bound to (index)
-		auto weightsIt = primitive.attributes.find("WEIGHTS_0"); // the influence (weight) of the corresponding bones
-
-		if (jointsIt != primitive.attributes.end() && weightsIt != primitive.attributes.end()) {
-			int jointsAccessorIndex = jointsIt->second;
-			int weightsAccessorIndex = weightsIt->second;
-
-			tinygltf::Accessor const& jointsAccessor = gltfModel.accessors[jointsAccessorIndex];
-			tinygltf::BufferView const& jointsBufferView = gltfModel.bufferViews[jointsAccessor.bufferView];
-			tinygltf::Buffer const& jointsBuffer = gltfModel.buffers[jointsBufferView.buffer];
-
-			tinygltf::Accessor const& weightsAccessor = gltfModel.accessors[weightsAccessorIndex];
-			tinygltf::BufferView const& weightsBufferView = gltfModel.bufferViews[weightsAccessor.bufferView];
-			tinygltf::Buffer const& weightsBuffer = gltfModel.buffers[weightsBufferView.buffer];
-
-			size_t vertexCount = jointsAccessor.count;
-			model->vertexJoints.resize(vertexCount);
-
-			if (jointsAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-				uint16_t const* jointData = reinterpret_cast<uint16_t const*>(&jointsBuffer.data[jointsBufferView.byteOffset + jointsAccessor.byteOffset]);
-				float const* weightData = reinterpret_cast<float const*>(&weightsBuffer.data[weightsBufferView.byteOffset + weightsAccessor.byteOffset]);
-
-				for (size_t i = 0; i < vertexCount; i++) {
-					for (int j = 0; j < 4; j++) {
-						int jointIndex = jointData[i * 4 + j];
-						float weight = weightData[i * 4 + j];
-
-						if (weight > 0.0f) {
-							model->vertexJoints[i].push_back(std::make_pair(jointIndex, weight));
-						}
-					}
-				}
-			}
-			else if (jointsAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-				uint8_t const* jointData = reinterpret_cast<uint8_t const*>(&jointsBuffer.data[jointsBufferView.byteOffset + jointsAccessor.byteOffset]);
-				float const* weightData = reinterpret_cast<float const*>(&weightsBuffer.data[weightsBufferView.byteOffset + weightsAccessor.byteOffset]);
-
-				for (size_t i = 0; i < vertexCount; i++) {
-					for (int j = 0; j < 4; j++) {
-						int jointIndex = jointData[i * 4 + j];
-						float weight = weightData[i * 4 + j];
-
-						if (weight > 0.0f) {
-							model->vertexJoints[i].push_back(std::make_pair(jointIndex, weight));
-						}
-					}
-				}
-			}
-
-			// std::cout << "[GltfLoader INFO] Loaded joint weights for " << vertexCount << " vertices" << std::endl;
-		}
-	}
+	// Joint matrices live in each pose, see Model::composePose
+	model->jointCount = skin.joints.size();
 }
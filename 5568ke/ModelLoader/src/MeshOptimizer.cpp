@@ -0,0 +1,401 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Hash.hpp"
+#include "Mesh.hpp"
+#include "Vertex.hpp"
+
+namespace {
+
+// Tom Forsyth's linear-speed vertex cache optimization, the weights are the ones from his article
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float vertexScore(int cachePosition, std::size_t remainingTriangles)
+{
+	if (remainingTriangles == 0)
+		return -1.0f; // Nothing left to draw with this vertex
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		// The three vertices of the last triangle get a fixed score so it does not matter which one comes first
+		if (cachePosition < 3)
+			score = kLastTriangleScore;
+		else
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(MeshOptimizer::kCacheSize - 3), kCacheDecayPower);
+	}
+
+	// Vertices with few triangles left are finished off first so they do not linger as lone triangles
+	score += kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+	return score;
+}
+
+// Order of the triangles of 'indices' (local vertex ids below 'vertexCount')
+std::vector<std::size_t> optimizeVertexCache(std::vector<unsigned int> const& indices, std::size_t vertexCount)
+{
+	std::size_t const triangleCount = indices.size() / 3;
+
+	// Triangles of each vertex, the first 'remaining' entries of a vertex are the ones not drawn yet
+	std::vector<std::size_t> offsets(vertexCount + 1, 0);
+	for (unsigned int index : indices)
+		++offsets[index + 1];
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] += offsets[v];
+	std::vector<std::size_t> adjacency(indices.size());
+	std::vector<std::size_t> remaining(vertexCount, 0);
+	for (std::size_t t = 0; t < triangleCount; ++t) {
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[t * 3 + k];
+			adjacency[offsets[v] + remaining[v]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		score[v] = vertexScore(-1, remaining[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> drawn(triangleCount, false);
+	for (std::size_t t = 0; t < triangleCount; ++t)
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+	std::vector<std::size_t> order;
+	order.reserve(triangleCount);
+	std::vector<unsigned int> cache, nextCache;
+	cache.reserve(MeshOptimizer::kCacheSize + 3);
+	nextCache.reserve(MeshOptimizer::kCacheSize + 3);
+
+	std::size_t best = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+	std::size_t scanCursor = 0;
+	while (order.size() < triangleCount) {
+		if (best == triangleCount) {
+			// Nothing in the cache has triangles left, start again from the next undrawn one
+			while (drawn[scanCursor])
+				++scanCursor;
+			best = scanCursor;
+		}
+
+		order.push_back(best);
+		drawn[best] = true;
+
+		// The triangle's vertices move to the front of the cache and it leaves their adjacency lists
+		nextCache.clear();
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[best * 3 + k];
+			nextCache.push_back(v);
+			std::size_t* begin = adjacency.data() + offsets[v];
+			std::size_t* it = std::find(begin, begin + remaining[v], best);
+			std::swap(*it, begin[--remaining[v]]);
+		}
+		for (unsigned int v : cache) {
+			if (std::find(nextCache.begin(), nextCache.begin() + 3, v) == nextCache.begin() + 3)
+				nextCache.push_back(v);
+		}
+
+		// Rescore everything that was or is in the cache, the best triangle next to it is drawn next
+		for (std::size_t i = 0; i < nextCache.size(); ++i) {
+			unsigned int v = nextCache[i];
+			cachePosition[v] = i < MeshOptimizer::kCacheSize ? static_cast<int>(i) : -1;
+			score[v] = vertexScore(cachePosition[v], remaining[v]);
+		}
+
+		best = triangleCount;
+		float bestScore = -1.0f;
+		for (unsigned int v : nextCache) {
+			for (std::size_t a = 0; a < remaining[v]; ++a) {
+				std::size_t t = adjacency[offsets[v] + a];
+				triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+				if (triangleScore[t] > bestScore) {
+					bestScore = triangleScore[t];
+					best = t;
+				}
+			}
+		}
+
+		if (nextCache.size() > MeshOptimizer::kCacheSize)
+			nextCache.resize(MeshOptimizer::kCacheSize);
+		std::swap(cache, nextCache);
+	}
+
+	return order;
+}
+
+// Splits a cache-optimized triangle order into clusters where the cache runs cold anyway, then draws outward-facing
+// clusters first: they are the likeliest to occlude the rest of the mesh (the Tipsify heuristic)
+std::vector<std::size_t> optimizeOverdraw(std::vector<unsigned int> const& indices, std::vector<std::size_t> const& order, std::vector<glm::vec3> const& positions)
+{
+	constexpr std::size_t kMinClusterSize = 16;
+
+	std::vector<std::size_t> clusterStarts{0};
+	std::vector<unsigned int> fifo;
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		int misses = 0;
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = indices[order[i] * 3 + k];
+			if (std::find(fifo.begin(), fifo.end(), v) == fifo.end()) {
+				++misses;
+				fifo.push_back(v);
+				if (fifo.size() > MeshOptimizer::kMeasureCacheSize)
+					fifo.erase(fifo.begin());
+			}
+		}
+		if (misses == 3 && i - clusterStarts.back() >= kMinClusterSize)
+			clusterStarts.push_back(i);
+	}
+	if (clusterStarts.size() < 2)
+		return order;
+	clusterStarts.push_back(order.size());
+
+	glm::vec3 meshCenter(0.0f);
+	for (std::size_t t : order)
+		meshCenter += positions[indices[t * 3]] + positions[indices[t * 3 + 1]] + positions[indices[t * 3 + 2]];
+	meshCenter /= static_cast<float>(order.size() * 3);
+
+	struct Cluster {
+		std::size_t begin, end;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters;
+	for (std::size_t c = 0; c + 1 < clusterStarts.size(); ++c) {
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (std::size_t i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i) {
+			std::size_t t = order[i];
+			glm::vec3 a = positions[indices[t * 3]], b = positions[indices[t * 3 + 1]], d = positions[indices[t * 3 + 2]];
+			glm::vec3 n = glm::cross(b - a, d - a); // Length is twice the area
+			float triangleArea = glm::length(n);
+			center += (a + b + d) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		center = area > 0.0f ? center / area : meshCenter;
+		float normalLength = glm::length(normal);
+		float key = normalLength > 0.0f ? glm::dot(center - meshCenter, normal / normalLength) : 0.0f;
+		clusters.push_back({clusterStarts[c], clusterStarts[c + 1], key});
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const& a, Cluster const& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<std::size_t> sorted;
+	sorted.reserve(order.size());
+	for (auto const& cluster : clusters)
+		sorted.insert(sorted.end(), order.begin() + cluster.begin, order.begin() + cluster.end);
+	return sorted;
+}
+
+// Merges bit-identical vertices, returns the number of distinct ones. Unused vertices are dropped later by the fetch reorder
+std::size_t weldVertices(Mesh& mesh)
+{
+	std::vector<Vertex> const& vertices = mesh.vertices;
+	auto hash = [&](unsigned int i) { return static_cast<std::size_t>(Hash::hashBytes(Hash::kSeed, &vertices[i], sizeof(Vertex))); };
+	auto equal = [&](unsigned int a, unsigned int b) { return std::memcmp(&vertices[a], &vertices[b], sizeof(Vertex)) == 0; };
+	std::unordered_map<unsigned int, unsigned int, decltype(hash), decltype(equal)> unique(vertices.size(), hash, equal);
+
+	std::vector<unsigned int> remap(vertices.size());
+	for (unsigned int i = 0; i < vertices.size(); ++i)
+		remap[i] = unique.emplace(i, i).first->second;
+
+	for (unsigned int& index : mesh.indices)
+		index = remap[index];
+	return unique.size();
+}
+
+// Vertices in the order the index buffer first reaches them, so the vertex fetch walks memory forward
+void optimizeVertexFetch(Mesh& mesh)
+{
+	std::vector<int> newIndex(mesh.vertices.size(), -1);
+	std::vector<Vertex> reordered;
+	reordered.reserve(mesh.vertices.size());
+	for (unsigned int& index : mesh.indices) {
+		if (newIndex[index] < 0) {
+			newIndex[index] = static_cast<int>(reordered.size());
+			reordered.push_back(mesh.vertices[index]);
+		}
+		index = static_cast<unsigned int>(newIndex[index]);
+	}
+	mesh.vertices = std::move(reordered);
+}
+
+// Splits triangles[begin, end) at the median centroid along the longest axis of their centroids until each part has at most
+// maxTriangles, appending the end of each part to 'ends' in order
+void splitCluster(std::vector<std::size_t>& triangles, std::size_t begin, std::size_t end, std::vector<glm::vec3> const& centroids,
+									std::size_t maxTriangles, std::vector<std::size_t>& ends)
+{
+	if (end - begin <= maxTriangles) {
+		ends.push_back(end);
+		return;
+	}
+
+	glm::vec3 lowest(std::numeric_limits<float>::max()), highest(std::numeric_limits<float>::lowest());
+	for (std::size_t i = begin; i < end; ++i) {
+		lowest = glm::min(lowest, centroids[triangles[i]]);
+		highest = glm::max(highest, centroids[triangles[i]]);
+	}
+	glm::vec3 size = highest - lowest;
+	int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+
+	std::size_t middle = begin + (end - begin) / 2;
+	std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+									 [&](std::size_t a, std::size_t b) { return centroids[a][axis] < centroids[b][axis]; });
+	splitCluster(triangles, begin, middle, centroids, maxTriangles, ends);
+	splitCluster(triangles, middle, end, centroids, maxTriangles, ends);
+}
+
+} // namespace
+
+namespace MeshOptimizer {
+
+Report& Report::operator+=(Report const& other)
+{
+	verticesBefore += other.verticesBefore;
+	verticesAfter += other.verticesAfter;
+	triangles += other.triangles;
+	transformsBefore += other.transformsBefore;
+	transformsAfter += other.transformsAfter;
+	indexBytesBefore += other.indexBytesBefore;
+	indexBytesAfter += other.indexBytesAfter;
+	return *this;
+}
+
+std::size_t countTransforms(Mesh const& mesh, std::size_t cacheSize)
+{
+	std::size_t transforms = 0;
+	std::vector<unsigned int> fifo;
+	for (auto const& prim : mesh.primitives) {
+		// Every draw call starts with a cold cache
+		fifo.clear();
+		for (std::size_t i = prim.indexOffset; i < prim.indexOffset + prim.indexCount; ++i) {
+			unsigned int v = mesh.indices[i];
+			if (std::find(fifo.begin(), fifo.end(), v) != fifo.end())
+				continue;
+			++transforms;
+			fifo.push_back(v);
+			if (fifo.size() > cacheSize)
+				fifo.erase(fifo.begin());
+		}
+	}
+	return transforms;
+}
+
+std::size_t clusterPrimitives(Mesh& mesh, std::size_t maxTriangles)
+{
+	if (maxTriangles == 0)
+		return 0;
+
+	std::vector<Primitive> clustered;
+	std::vector<std::size_t> triangles, ends;
+	std::vector<glm::vec3> centroids;
+	std::vector<unsigned int> reordered;
+	for (auto const& prim : mesh.primitives) {
+		std::size_t triangleCount = prim.indexCount / 3;
+		if (triangleCount <= maxTriangles) {
+			clustered.push_back(prim);
+			continue;
+		}
+
+		centroids.resize(triangleCount);
+		triangles.resize(triangleCount);
+		for (std::size_t t = 0; t < triangleCount; ++t) {
+			unsigned int const* tri = mesh.indices.data() + prim.indexOffset + t * 3;
+			centroids[t] = (mesh.vertices[tri[0]].position + mesh.vertices[tri[1]].position + mesh.vertices[tri[2]].position) / 3.0f;
+			triangles[t] = t;
+		}
+
+		ends.clear();
+		splitCluster(triangles, 0, triangleCount, centroids, maxTriangles, ends);
+
+		// The clusters take over the primitive's index range in their new order
+		reordered.assign(mesh.indices.begin() + prim.indexOffset, mesh.indices.begin() + prim.indexOffset + triangleCount * 3);
+		for (std::size_t t = 0; t < triangleCount; ++t) {
+			for (int k = 0; k < 3; ++k)
+				mesh.indices[prim.indexOffset + t * 3 + k] = reordered[triangles[t] * 3 + k];
+		}
+
+		std::size_t begin = 0;
+		for (std::size_t end : ends) {
+			Primitive cluster = prim;
+			cluster.indexOffset = prim.indexOffset + static_cast<unsigned int>(begin * 3);
+			cluster.indexCount = static_cast<unsigned int>((end - begin) * 3);
+			clustered.push_back(cluster);
+			begin = end;
+		}
+	}
+
+	std::size_t added = clustered.size() - mesh.primitives.size();
+	mesh.primitives = std::move(clustered);
+	// std::cout << "[MeshOptimizer INFO] Split into " << added << " more clusters" << std::endl;
+	return added;
+}
+
+Report optimize(Mesh& mesh)
+{
+	Report report;
+	report.verticesBefore = mesh.vertices.size();
+	report.indexBytesBefore = mesh.indices.size() * sizeof(unsigned int);
+	report.transformsBefore = countTransforms(mesh);
+	for (auto const& prim : mesh.primitives)
+		report.triangles += prim.indexCount / 3;
+
+	if (mesh.indices.empty() || mesh.vertices.empty()) {
+		report.verticesAfter = report.verticesBefore;
+		report.transformsAfter = report.transformsBefore;
+		return report;
+	}
+
+	weldVertices(mesh);
+
+	// Triangles never move between primitives, each one is reordered on its own with local vertex ids
+	std::vector<int> localIndex(mesh.vertices.size(), -1);
+	std::vector<unsigned int> globalIndex;
+	std::vector<unsigned int> local;
+	std::vector<glm::vec3> positions;
+	for (auto const& prim : mesh.primitives) {
+		std::size_t triangleCount = prim.indexCount / 3;
+		if (triangleCount < 2)
+			continue;
+
+		globalIndex.clear();
+		local.clear();
+		positions.clear();
+		for (std::size_t i = prim.indexOffset; i < prim.indexOffset + triangleCount * 3; ++i) {
+			unsigned int v = mesh.indices[i];
+			if (localIndex[v] < 0) {
+				localIndex[v] = static_cast<int>(globalIndex.size());
+				globalIndex.push_back(v);
+				positions.push_back(mesh.vertices[v].position);
+			}
+			local.push_back(static_cast<unsigned int>(localIndex[v]));
+		}
+
+		std::vector<std::size_t> order = optimizeOverdraw(local, optimizeVertexCache(local, globalIndex.size()), positions);
+		for (std::size_t t = 0; t < order.size(); ++t) {
+			for (int k = 0; k < 3; ++k)
+				mesh.indices[prim.indexOffset + t * 3 + k] = globalIndex[local[order[t] * 3 + k]];
+		}
+
+		for (unsigned int v : globalIndex)
+			localIndex[v] = -1;
+	}
+
+	optimizeVertexFetch(mesh);
+
+	report.verticesAfter = mesh.vertices.size();
+	report.transformsAfter = countTransforms(mesh);
+	// std::cout << "[MeshOptimizer INFO] " << report.verticesBefore << " -> " << report.verticesAfter << " vertices, ACMR " << report.acmrBefore()
+	// << " -> " << report.acmrAfter() << std::endl;
+	return report;
+}
+
+} // namespace MeshOptimizer
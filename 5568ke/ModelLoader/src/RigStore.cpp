@@ -0,0 +1,60 @@
+#include "RigStore.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "AnimationClip.hpp"
+#include "Model.hpp"
+
+std::shared_ptr<Rig const> RigStore::internRig(std::shared_ptr<Rig const> rig)
+{
+	if (!rig)
+		return rig;
+
+	auto it = rigs_.find(rig->signature);
+	if (it != rigs_.end()) {
+		std::shared_ptr<Rig const> stored = it->second.lock();
+
+		// The signature already covers the skin, comparing it as well rules out hash collisions
+		if (stored && stored->jointNodes == rig->jointNodes && stored->inverseBindMatrices.size() == rig->inverseBindMatrices.size() &&
+				std::memcmp(stored->inverseBindMatrices.data(), rig->inverseBindMatrices.data(), rig->inverseBindMatrices.size() * sizeof(glm::mat4)) == 0) {
+			++stats_.sharedRigs;
+			stats_.bytesSaved += rig->getMemoryBytes();
+			// std::cout << "[RigStore INFO] Sharing rig with " << rig->jointNodes.size() << " joints" << std::endl;
+			return stored;
+		}
+	}
+
+	rigs_[rig->signature] = rig;
+	return rig;
+}
+
+std::shared_ptr<AnimationClip> RigStore::findClip(std::uint64_t key, std::vector<unsigned char> const& data)
+{
+	auto it = clips_.find(key);
+	if (it == clips_.end())
+		return nullptr;
+
+	std::shared_ptr<AnimationClip> clip = it->second.clip.lock();
+	if (!clip) {
+		clips_.erase(it);
+		return nullptr;
+	}
+
+	// Same check as for rigs, a key collision must not hand out another clip's keyframes
+	std::vector<unsigned char> const& stored = it->second.data;
+	if (stored.size() != data.size() || std::memcmp(stored.data(), data.data(), data.size()) != 0)
+		return nullptr;
+
+	// A lazy clip's packed keyframes are not part of its decoded size
+	++stats_.sharedClips;
+	stats_.bytesSaved += clip->getMemoryBytes() + clip->getSourceBytes();
+	// std::cout << "[RigStore INFO] Sharing clip '" << clip->clipName << "'" << std::endl;
+	return clip;
+}
+
+void RigStore::addClip(std::uint64_t key, std::shared_ptr<AnimationClip> const& clip, std::vector<unsigned char> data)
+{
+	clips_[key] = ClipEntry{clip, std::move(data)};
+}
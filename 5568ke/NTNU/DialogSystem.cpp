@@ -20,6 +20,8 @@
 #include "GameObject.hpp"    // For GameObject (already in DialogSystem.hpp, but good for explicitness)
 #include "Model.hpp"         // For Model definition
 #include "AnimationClip.hpp" // For AnimationClip definition
+#include "AnimationInstance.hpp"
+#include "GlobalAnimationState.hpp"
 
 // -------- Implementation of DialogSystem methods --------
 
@@ -41,7 +43,6 @@ NPC& DialogSystem::addNPC(std::shared_ptr<GameObject> go, std::vector<std::share
         0,                          // lineIndex
         0,                          // totalScore
         false,                      // isPlayingIdleAnimation
-        0.0f,                       // idleAnimationTime
         -1                          // idleAnimationIndex
     });
 
@@ -74,6 +75,12 @@ void DialogSystem::initializeNPCIdleAnimation(NPC& npc)
 	}
 	npc.idleAnimationIndex = findIdleAnimationIndex(npc.go);
 	if (npc.idleAnimationIndex != -1) {
+		// Idle loops play every frame for every NPC, sample them from baked pose tables
+		auto const& idleClip = npc.go->getModel()->animations[npc.idleAnimationIndex];
+		GlobalAnimationState const& animState = GlobalAnimationState::getInstance();
+		if (idleClip && animState.bakeIdleClips && !idleClip->isBaked())
+			idleClip->bake(animState.bakeSampleRate);
+
 		startIdleAnimation(npc);
 	}
 }
@@ -105,16 +112,14 @@ void DialogSystem::startIdleAnimation(NPC& npc)
 		return;
 	}
 	auto model = npc.go->getModel();
-	if (static_cast<size_t>(npc.idleAnimationIndex) >= model->animations.size() || !model->animations[npc.idleAnimationIndex]) {
+	if (static_cast<size_t>(npc.idleAnimationIndex) >= model->animations.size() || !model->animations[npc.idleAnimationIndex] || !npc.go->hasAnimation()) {
 		return;
 	}
 	npc.isPlayingIdleAnimation = true;
-	npc.idleAnimationTime = 0.0f;
-	model->animations[npc.idleAnimationIndex]->setAnimationFrame(model->nodes, 0.0f);
-	model->updateLocalMatrices();
+	npc.go->getAnimation()->play(npc.idleAnimationIndex); // The AnimationSystem advances it from here
 }
 
-void DialogSystem::updateNPCIdleAnimation(NPC& npc, float dt)
+void DialogSystem::updateNPCIdleAnimation(NPC& npc)
 {
     if (!npc.go || !npc.go->getModel() || npc.idleAnimationIndex == -1) {
         return;
@@ -122,33 +127,17 @@ void DialogSystem::updateNPCIdleAnimation(NPC& npc, float dt)
     if (npc.inDialog) {
         if (npc.isPlayingIdleAnimation) {
             npc.isPlayingIdleAnimation = false; 
+            if (npc.go->hasAnimation())
+                npc.go->getAnimation()->pause(); // Hold the pose while talking
         }
         return; 
     }
 	if (!npc.isPlayingIdleAnimation) { 
 		startIdleAnimation(npc); 
-        if (!npc.isPlayingIdleAnimation) return; 
-	}
-	if (npc.isPlayingIdleAnimation) {
-		auto model = npc.go->getModel();
-		if (static_cast<size_t>(npc.idleAnimationIndex) < model->animations.size() && model->animations[npc.idleAnimationIndex]) {
-			auto const& idleClip = model->animations[npc.idleAnimationIndex];
-			npc.idleAnimationTime += dt;
-			float duration = idleClip->getDuration();
-			if (duration > 0.0f) { 
-				npc.idleAnimationTime = std::fmod(npc.idleAnimationTime, duration);
-			} else {
-                npc.idleAnimationTime = 0.0f; 
-            }
-			idleClip->setAnimationFrame(model->nodes, npc.idleAnimationTime);
-			model->updateLocalMatrices();
-		} else {
-            npc.isPlayingIdleAnimation = false;
-        }
 	}
 }
 
-void DialogSystem::update(Scene& scene, float dt)
+void DialogSystem::update(Scene& scene)
 {
 	std::shared_ptr<GameObject> player = nullptr;
     static bool playerSearchedAndWarned = false; 
@@ -179,7 +168,7 @@ void DialogSystem::update(Scene& scene, float dt)
         }
         for (auto& npc_iter : npcs_) {
             if (npc_iter.go && npc_iter.go->visible) {
-                updateNPCIdleAnimation(npc_iter, dt);
+                updateNPCIdleAnimation(npc_iter);
             }
             npc_iter.showIcon = false; 
         }
@@ -211,7 +200,7 @@ void DialogSystem::update(Scene& scene, float dt)
             }
 			continue;
 		}
-		updateNPCIdleAnimation(npc_iter, dt); 
+		updateNPCIdleAnimation(npc_iter); 
 
 		if (npc_iter.inDialog) {
             if (npc_iter.showIcon) { 
@@ -48,8 +48,7 @@ struct NPC {
 	size_t lineIndex{0};
 	int totalScore{0};
 	bool isPlayingIdleAnimation{false};
-	float idleAnimationTime{0.0f};
-	int idleAnimationIndex{-1};
+	int idleAnimationIndex{-1}; // Played on the NPC's own AnimationInstance
 };
 
 // DialogSystem Class Declaration
@@ -59,7 +58,7 @@ public:
 
 	NPC& addNPC(std::shared_ptr<GameObject> go, std::vector<std::shared_ptr<DialogBase>> script);
 
-	void update(Scene& scene, float dt);
+	void update(Scene& scene);
 	void render(Scene const& scene);
 	void processInput(GLFWwindow* window);
 
@@ -79,7 +78,7 @@ private:
 	void handleDialogProgress(NPC& npc);
 
 	void initializeNPCIdleAnimation(NPC& npc);
-	void updateNPCIdleAnimation(NPC& npc, float dt);
+	void updateNPCIdleAnimation(NPC& npc);
 	void startIdleAnimation(NPC& npc);
 	// int findIdleAnimationIndex(std::shared_ptr<GameObject> const& go); // Removed from private if it was here
 
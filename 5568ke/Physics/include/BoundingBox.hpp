@@ -4,6 +4,7 @@
 
 class Mesh;
 class Model;
+struct Pose;
 
 struct BoundingBox {
 	glm::vec3 min;
@@ -13,7 +14,13 @@ struct BoundingBox {
 namespace BBoxUtil {
 BoundingBox getMeshBBox(Mesh const& mesh);
 glm::vec3 getBBoxCenter(BoundingBox const&);
+BoundingBox emptyBBox(); // min > max, merging anything into it gives that thing
+bool isEmptyBBox(BoundingBox const& box);
+BoundingBox transformBBox(BoundingBox const& box, glm::mat4 const& M); // Box around the transformed box
 void updateLocalBBox(Model& m);
+void computeJointBounds(Model& model); // Per-joint boxes of the skinned vertices, once at load
+BoundingBox computeLocalBBox(Model const& model, Pose const& pose); // Bounds of one animated instance of the model
 bool isIntersectBBox(BoundingBox const& a, BoundingBox const& b);
+bool isInsideFrustum(BoundingBox const& box, glm::mat4 const& viewProj); // Conservative, true when the box may be visible
 BoundingBox mergeBBox(BoundingBox const& a, BoundingBox const& b);
 } // namespace BBoxUtil
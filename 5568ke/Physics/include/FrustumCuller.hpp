@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.hpp"
+
+// Where a box lies relative to a frustum. Children of an INSIDE box need no test of their own
+enum FrustumResult : std::uint8_t { FRUSTUM_OUTSIDE = 0, FRUSTUM_INTERSECTS = 1, FRUSTUM_INSIDE = 2 };
+
+/**
+ * @brief Axis-aligned boxes as center and half extent planes, so a batch of them is tested against a plane at once.
+ *
+ */
+struct BoundsSoA {
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	void clear();
+	void push(BoundingBox const& box);
+	std::size_t size() const { return centerX.size(); }
+};
+
+/**
+ * @brief The six clip planes of a view-projection matrix. A box is culled only when it lies fully behind one of them, so
+ * boxes around the camera (e.g. the classroom) and boxes larger than the view are kept.
+ */
+class Frustum {
+public:
+	Frustum() = default;
+	explicit Frustum(glm::mat4 const& viewProj);
+
+	FrustumResult classify(BoundingBox const& box) const;
+
+	// results[i] = classification of box i, SIMD over the batch. Returns the number of boxes that may be visible
+	std::size_t classify(BoundsSoA const& bounds, FrustumResult* results) const;
+
+private:
+	glm::vec4 planes_[6]{}; // xyz: inward normal, w: offset, not normalized
+};
@@ -2,29 +2,16 @@
 
 #include "BoundingBox.hpp"
 
+#include <limits>
+
+#include "FrustumCuller.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
-#include "Node.hpp"
+#include "PosePool.hpp"
 
 namespace BBoxUtil {
 namespace {
-BoundingBox transformBBox(BoundingBox const& in, glm::mat4 const& M)
-{
-	BoundingBox out;
-	out.min = glm::vec3(std::numeric_limits<float>::max());
-	out.max = glm::vec3(std::numeric_limits<float>::lowest());
-
-	// 8 個 corner
-	for (int c = 0; c < 8; ++c) {
-		glm::vec3 p = {(c & 1 ? in.max.x : in.min.x), (c & 2 ? in.max.y : in.min.y), (c & 4 ? in.max.z : in.min.z)};
-		p = glm::vec3(M * glm::vec4(p, 1.0f));
-		out.min = glm::min(out.min, p);
-		out.max = glm::max(out.max, p);
-	}
-	return out;
-}
-
-BoundingBox getSkinnedMeshBBox(Mesh const& mesh, Model const& model)
+BoundingBox getSkinnedMeshBBox(Mesh const& mesh, glm::mat4 const* jointMatrices, std::size_t jointCount)
 {
 	BoundingBox bbox;
 	bbox.min = glm::vec3(std::numeric_limits<float>::max());
@@ -40,8 +27,8 @@ BoundingBox getSkinnedMeshBBox(Mesh const& mesh, Model const& model)
 			int id = v.boneIds[i];
 
 			// do the linear blend skinning
-			if (w > 0.0f && id >= 0 && static_cast<std::size_t>(id) < model.jointMatrices.size()) {
-				skinned += w * model.jointMatrices[id] * pos;
+			if (w > 0.0f && id >= 0 && static_cast<std::size_t>(id) < jointCount) {
+				skinned += w * jointMatrices[id] * pos;
 				total += w;
 			}
 		}
@@ -57,15 +44,15 @@ BoundingBox getSkinnedMeshBBox(Mesh const& mesh, Model const& model)
 	return bbox;
 }
 
-BoundingBox getStaticMeshBox(Model const& model, size_t meshIndex)
+BoundingBox getStaticMeshBox(Model const& model, size_t meshIndex, Pose const& pose)
 {
 	BoundingBox local = model.boundingBoxes[meshIndex];
 	glm::mat4 nodeM(1.0f);
 
 	if (meshIndex < model.meshNodeIndices.size()) {
 		int nodeIdx = model.meshNodeIndices[meshIndex];
-		if (nodeIdx >= 0 && static_cast<std::size_t>(nodeIdx) < model.nodes.size() && model.nodes[nodeIdx])
-			nodeM = model.nodes[nodeIdx]->getNodeMatrix();
+		if (nodeIdx >= 0 && static_cast<std::size_t>(nodeIdx) < pose.nodeCount)
+			nodeM = glm::mat4(pose.worldMatrices[nodeIdx]);
 	}
 
 	return transformBBox(local, nodeM);
@@ -99,7 +86,54 @@ BoundingBox getMeshBBox(Mesh const& mesh)
 
 glm::vec3 getBBoxCenter(BoundingBox const& bb) { return (bb.min + bb.max) * 0.5f; }
 
-void updateLocalBBox(Model& model)
+BoundingBox emptyBBox() { return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())}; }
+
+bool isEmptyBBox(BoundingBox const& box) { return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z; }
+
+BoundingBox transformBBox(BoundingBox const& in, glm::mat4 const& M)
+{
+	// Center and half extent instead of 8 corners: the new extent along each axis is the absolute rotation-scale part applied to the old one
+	glm::vec3 center = (in.min + in.max) * 0.5f;
+	glm::vec3 extent = (in.max - in.min) * 0.5f;
+
+	glm::vec3 newCenter = glm::vec3(M * glm::vec4(center, 1.0f));
+	glm::mat3 absM(glm::abs(glm::vec3(M[0])), glm::abs(glm::vec3(M[1])), glm::abs(glm::vec3(M[2])));
+	glm::vec3 newExtent = absM * extent;
+	return {newCenter - newExtent, newCenter + newExtent};
+}
+
+void computeJointBounds(Model& model)
+{
+	model.jointBounds.assign(model.jointCount, emptyBBox());
+	model.unskinnedBounds = emptyBBox();
+
+	// A skinned vertex is a weighted average of its joints' transforms of it, so it stays inside the union of each joint's
+	// transformed box of the bind-space vertices that joint influences
+	for (auto const& mesh : model.meshes) {
+		for (auto const& v : mesh.vertices) {
+			bool skinned = false;
+			for (int i = 0; i < 4; ++i) {
+				int id = v.boneIds[i];
+				if (v.boneWeights[i] > 0.0f && id >= 0 && static_cast<std::size_t>(id) < model.jointCount) {
+					BoundingBox& box = model.jointBounds[id];
+					box.min = glm::min(box.min, v.position);
+					box.max = glm::max(box.max, v.position);
+					skinned = true;
+				}
+			}
+
+			// Vertices without weights are not moved by the skin
+			if (!skinned) {
+				model.unskinnedBounds.min = glm::min(model.unskinnedBounds.min, v.position);
+				model.unskinnedBounds.max = glm::max(model.unskinnedBounds.max, v.position);
+			}
+		}
+	}
+}
+
+void updateLocalBBox(Model& model) { model.localSpaceBBox = computeLocalBBox(model, model.bindPose.get()); }
+
+BoundingBox computeLocalBBox(Model const& model, Pose const& pose)
 {
 	BoundingBox global;
 	global.min = glm::vec3(std::numeric_limits<float>::max());
@@ -107,21 +141,31 @@ void updateLocalBBox(Model& model)
 
 	// When a model has skinning data, the mesh's node transform is typically baked into the inverse bind matrices.
 	// Applying the node matrix again would result in an oversized bounding box. Detect this case and avoid applying the extra transform.
-	bool hasSkinning = !model.jointMatrices.empty();
+	bool hasSkinning = pose.jointCount > 0;
+
+	// O(joints): each joint's bind-space box moved by its joint matrix
+	if (hasSkinning && model.jointBounds.size() == pose.jointCount) {
+		BoundingBox bounds = model.unskinnedBounds;
+		for (std::size_t j = 0; j < pose.jointCount; ++j) {
+			if (!isEmptyBBox(model.jointBounds[j]))
+				bounds = mergeBBox(bounds, transformBBox(model.jointBounds[j], pose.jointMatrices[j]));
+		}
+		return bounds;
+	}
 
 	for (size_t i = 0; i < model.meshes.size(); ++i) {
 		BoundingBox local;
 
 		if (hasSkinning)
-			local = getSkinnedMeshBBox(model.meshes[i], model);
+			local = getSkinnedMeshBBox(model.meshes[i], pose.jointMatrices, pose.jointCount);
 		else
-			local = getStaticMeshBox(model, i);
+			local = getStaticMeshBox(model, i, pose);
 
 		global.min = glm::min(global.min, local.min);
 		global.max = glm::max(global.max, local.max);
 	}
 
-	model.localSpaceBBox = global;
+	return global;
 }
 
 // Fast overlap test (inclusive)
@@ -130,6 +174,8 @@ bool isIntersectBBox(BoundingBox const& a, BoundingBox const& b)
 	return (a.min.x <= b.max.x && a.max.x >= b.min.x) && (a.min.y <= b.max.y && a.max.y >= b.min.y) && (a.min.z <= b.max.z && a.max.z >= b.min.z);
 }
 
+bool isInsideFrustum(BoundingBox const& box, glm::mat4 const& viewProj) { return Frustum(viewProj).classify(box) != FRUSTUM_OUTSIDE; }
+
 // Combine two boxes (useful for hierarchy/BVH later)
 BoundingBox mergeBBox(BoundingBox const& a, BoundingBox const& b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
 } // namespace BBoxUtil
@@ -0,0 +1,143 @@
+#include "FrustumCuller.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Thin wrappers so the batch test is written once for AVX, SSE and plain scalar builds, as in AnimationKernels
+#if defined(__AVX__)
+using Batch = __m256;
+constexpr std::size_t kBatchWidth = 8;
+inline Batch load(float const* p) { return _mm256_loadu_ps(p); }
+inline Batch set1(float v) { return _mm256_set1_ps(v); }
+inline Batch add(Batch a, Batch b) { return _mm256_add_ps(a, b); }
+inline Batch sub(Batch a, Batch b) { return _mm256_sub_ps(a, b); }
+inline Batch mul(Batch a, Batch b) { return _mm256_mul_ps(a, b); }
+inline Batch lessThan(Batch a, Batch b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Batch either(Batch a, Batch b) { return _mm256_or_ps(a, b); }
+inline Batch none() { return _mm256_setzero_ps(); }
+inline int laneBits(Batch mask) { return _mm256_movemask_ps(mask); }
+#elif defined(__SSE2__) || defined(_M_X64)
+using Batch = __m128;
+constexpr std::size_t kBatchWidth = 4;
+inline Batch load(float const* p) { return _mm_loadu_ps(p); }
+inline Batch set1(float v) { return _mm_set1_ps(v); }
+inline Batch add(Batch a, Batch b) { return _mm_add_ps(a, b); }
+inline Batch sub(Batch a, Batch b) { return _mm_sub_ps(a, b); }
+inline Batch mul(Batch a, Batch b) { return _mm_mul_ps(a, b); }
+inline Batch lessThan(Batch a, Batch b) { return _mm_cmplt_ps(a, b); }
+inline Batch either(Batch a, Batch b) { return _mm_or_ps(a, b); }
+inline Batch none() { return _mm_setzero_ps(); }
+inline int laneBits(Batch mask) { return _mm_movemask_ps(mask); }
+#else
+using Batch = float;
+constexpr std::size_t kBatchWidth = 1;
+inline Batch load(float const* p) { return *p; }
+inline Batch set1(float v) { return v; }
+inline Batch add(Batch a, Batch b) { return a + b; }
+inline Batch sub(Batch a, Batch b) { return a - b; }
+inline Batch mul(Batch a, Batch b) { return a * b; }
+inline Batch lessThan(Batch a, Batch b) { return a < b ? 1.0f : 0.0f; }
+inline Batch either(Batch a, Batch b) { return a != 0.0f || b != 0.0f ? 1.0f : 0.0f; }
+inline Batch none() { return 0.0f; }
+inline int laneBits(Batch mask) { return mask != 0.0f ? 1 : 0; }
+#endif
+
+} // namespace
+
+void BoundsSoA::clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+void BoundsSoA::push(BoundingBox const& box)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extent.x);
+	extentY.push_back(extent.y);
+	extentZ.push_back(extent.z);
+}
+
+Frustum::Frustum(glm::mat4 const& viewProj)
+{
+	// Clip planes straight from the rows of the view-projection matrix
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; ++r)
+		rows[r] = glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+
+	planes_[0] = rows[3] + rows[0];
+	planes_[1] = rows[3] - rows[0];
+	planes_[2] = rows[3] + rows[1];
+	planes_[3] = rows[3] - rows[1];
+	planes_[4] = rows[3] + rows[2];
+	planes_[5] = rows[3] - rows[2];
+}
+
+FrustumResult Frustum::classify(BoundingBox const& box) const
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+	FrustumResult result = FRUSTUM_INSIDE;
+	for (auto const& plane : planes_) {
+		// Signed distance of the center, and how far the box reaches along the plane normal
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+		if (distance + radius < 0.0f)
+			return FRUSTUM_OUTSIDE;
+		if (distance - radius < 0.0f)
+			result = FRUSTUM_INTERSECTS;
+	}
+	return result;
+}
+
+std::size_t Frustum::classify(BoundsSoA const& bounds, FrustumResult* results) const
+{
+	std::size_t const count = bounds.size();
+	std::size_t visible = 0;
+
+	std::size_t i = 0;
+	for (; i + kBatchWidth <= count; i += kBatchWidth) {
+		Batch cx = load(bounds.centerX.data() + i), cy = load(bounds.centerY.data() + i), cz = load(bounds.centerZ.data() + i);
+		Batch ex = load(bounds.extentX.data() + i), ey = load(bounds.extentY.data() + i), ez = load(bounds.extentZ.data() + i);
+
+		Batch outside = none(), crossing = none();
+		Batch const zero = set1(0.0f);
+		for (auto const& plane : planes_) {
+			Batch distance = add(add(mul(set1(plane.x), cx), mul(set1(plane.y), cy)), add(mul(set1(plane.z), cz), set1(plane.w)));
+			Batch radius = add(add(mul(set1(glm::abs(plane.x)), ex), mul(set1(glm::abs(plane.y)), ey)), mul(set1(glm::abs(plane.z)), ez));
+			outside = either(outside, lessThan(add(distance, radius), zero));
+			crossing = either(crossing, lessThan(sub(distance, radius), zero));
+		}
+
+		int outsideBits = laneBits(outside);
+		int crossingBits = laneBits(crossing);
+		for (std::size_t lane = 0; lane < kBatchWidth; ++lane) {
+			FrustumResult result = (outsideBits >> lane) & 1 ? FRUSTUM_OUTSIDE : (crossingBits >> lane) & 1 ? FRUSTUM_INTERSECTS : FRUSTUM_INSIDE;
+			results[i + lane] = result;
+			visible += result != FRUSTUM_OUTSIDE ? 1 : 0;
+		}
+	}
+
+	// Boxes left over after the last full batch
+	for (; i < count; ++i) {
+		glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+		glm::vec3 extent(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+		results[i] = classify(BoundingBox{center - extent, center + extent});
+		visible += results[i] != FRUSTUM_OUTSIDE ? 1 : 0;
+	}
+	return visible;
+}
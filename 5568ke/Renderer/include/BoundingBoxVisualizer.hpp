@@ -6,9 +6,9 @@
 
 #include <glm/glm.hpp>
 
+#include "Shader.hpp"
 #include "include_5568ke.hpp"
 
-class Shader;
 class Scene;
 class Model;
 class GameObject;
@@ -25,4 +25,6 @@ public:
 private:
 	BoundingBoxVisualizer() = default;
 	GLuint vao_{0}, vbo_{0};
+	UniformHandle<glm::mat4> viewLoc_, projLoc_, modelLoc_;
+	UniformHandle<glm::vec3> colorLoc_;
 };
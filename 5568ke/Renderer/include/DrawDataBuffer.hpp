@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "StreamingBuffer.hpp"
+#include "UniformBlocks.hpp"
+#include "include_5568ke.hpp"
+
+/**
+ * @brief Per-draw data (model matrix, normal matrix, skinning) of every mesh drawn in a frame, staged back to back and
+ * uploaded in one transfer. Records are spaced by the uniform buffer offset alignment, so selecting a draw's record is a
+ * single glBindBufferRange instead of a handful of glUniform calls.
+ */
+class DrawDataBuffer {
+public:
+	void init();		// create the buffer, query the offset alignment
+	void cleanup(); // destroy GL objects
+
+	void clear();																// Starts a new frame
+	int append(DrawBlock const& draw);					// Stages one record, returns its index
+	int append(std::size_t count);							// Stages 'count' records to be filled with set(), returns the first index
+	void set(int draw, DrawBlock const& block); // Fills a staged record, distinct records may be set from different threads
+	DrawBlock get(int draw) const;							// Reads back a staged record
+	void upload();															// Sends everything staged since clear() in one transfer
+	void bind(int draw) const;									// Binds record 'draw' to DrawBlock::kBinding
+
+	std::size_t getDrawCount() const { return stride_ ? staging_.size() / stride_ : 0; }
+	std::size_t getCapacityBytes() const { return buffer_.getCapacityBytes(); }
+
+private:
+	std::vector<unsigned char> staging_;
+	std::size_t stride_{}; // sizeof(DrawBlock) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	StreamingBuffer buffer_{GL_UNIFORM_BUFFER};
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "UniformBlocks.hpp"
+#include "include_5568ke.hpp"
+
+/**
+ * @brief The uniform buffer behind the shaders' 'Frame' block (camera and lighting). Uploaded and bound once per frame,
+ * it replaces sending view, proj, viewPos and lightPos to every shader separately.
+ */
+class FrameUniformBuffer {
+public:
+	void init();		// create the buffer
+	void cleanup(); // destroy GL objects
+
+	void upload(FrameBlock const& frame); // Sends the frame's data and binds it to FrameBlock::kBinding
+
+private:
+	GLuint buffer_{0};
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "InstanceData.hpp"
+#include "StreamingBuffer.hpp"
+#include "include_5568ke.hpp"
+
+/**
+ * @brief Per-instance data of every instanced draw in a frame, staged back to back and uploaded in one transfer.
+ * Each draw points the instance attributes of its mesh at its own range (see Mesh::bindInstances).
+ */
+class InstanceBuffer {
+public:
+	void init();		// create the buffer
+	void cleanup(); // destroy GL objects
+
+	void clear();															// Starts a new frame
+	int append(InstanceData const& instance); // Stages one instance, returns its index
+	void upload();														// Sends everything staged since clear() in one transfer
+
+	GLuint getBuffer() const { return buffer_.getBuffer(); }
+	std::size_t getInstanceCount() const { return staging_.size(); }
+
+private:
+	std::vector<InstanceData> staging_;
+	StreamingBuffer buffer_{GL_ARRAY_BUFFER};
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "StreamingBuffer.hpp"
+#include "include_5568ke.hpp"
+
+struct Pose;
+
+/**
+ * @brief Joint matrices of every skinned object drawn in a frame, packed back to back into one texture buffer and
+ * uploaded once. A draw only sends the offset of its first joint, the skinned shader fetches its matrices from there.
+ */
+class JointPaletteBuffer {
+public:
+	static constexpr int kTextureUnit = 8; // Above the units used by materials
+
+	void init();		// create the buffer and its texture view
+	void cleanup(); // destroy GL objects
+
+	void clear();									// Starts a new frame
+	int append(Pose const& pose); // Stages the joint matrices of 'pose', returns the offset of its first joint
+	void upload();								// Sends everything staged since clear() in one transfer
+	void bind() const;						// Binds the palette to kTextureUnit, the shader's 'jointPalette' sampler must point there
+
+	std::size_t getJointCount() const { return staging_.size(); }
+	std::size_t getCapacityBytes() const { return buffer_.getCapacityBytes(); }
+
+private:
+	std::vector<glm::mat4> staging_;
+	StreamingBuffer buffer_{GL_TEXTURE_BUFFER};
+	GLuint texture_{0};
+};
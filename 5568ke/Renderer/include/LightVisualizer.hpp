@@ -5,9 +5,9 @@
 
 #include <glm/glm.hpp>
 
+#include "Shader.hpp"
 #include "include_5568ke.hpp"
 
-class Shader;
 class Scene;
 
 class LightPointVisualizer {
@@ -21,5 +21,7 @@ public:
 
 private:
 	GLuint vao_{0}, vbo_{0};
+	UniformHandle<glm::mat4> viewLoc_, projLoc_;
+	UniformHandle<float> pointSizeLoc_;
 	LightPointVisualizer() = default;
 };
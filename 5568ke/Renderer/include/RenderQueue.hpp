@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+struct Primitive;
+
+// Coarsest part of the sort key, single-sided primitives draw first so culling is toggled once per frame
+enum class RenderPass : unsigned int { SOLID = 0, DOUBLE_SIDED = 1 };
+
+/**
+ * @brief One primitive to draw. Holds everything submission needs, so the submit loop never touches the scene.
+ *
+ */
+struct DrawPacket {
+	std::uint64_t key;					// Ordering of the packet, see RenderQueue::makeKey
+	Mesh const* mesh;						// Owner of the primitive's vertex and index buffers
+	Primitive const* primitive; // Index range and material
+	int drawRecord;							// Index of the mesh's record in the frame's DrawDataBuffer
+	unsigned int features;			// ShaderFeature keys of the permutation to draw with
+};
+
+/**
+ * @brief A run of sorted packets drawing the same primitive with the same permutation, drawn with one call.
+ *
+ */
+struct DrawBatch {
+	std::size_t firstPacket;
+	int packetCount;			 // Instances of the draw, one per packet
+	int firstInstance{-1}; // Index in the frame's InstanceBuffer when drawn instanced
+};
+
+/**
+ * @brief The frame's draw packets, sorted by key before they are submitted. The key orders by pass, then program, then
+ * material, then primitive, then front to back, so consecutive packets mostly share their state, the instances of a primitive
+ * end up next to each other (see DrawBatch), and near instances fill the depth buffer first.
+ * resize() leaves a slot per packet, the slots can be filled from several threads as long as each is written by one.
+ */
+class RenderQueue {
+public:
+	// Fields of the sort key, from the most to the least significant bits
+	static constexpr int kPassBits = 2;
+	static constexpr int kProgramBits = 8;
+	static constexpr int kMaterialBits = 22;
+	static constexpr int kPrimitiveBits = 16;
+	static constexpr int kDepthBits = 16;
+	static constexpr std::uint64_t kCulledKey = ~std::uint64_t{0}; // Slots left empty by culling, sort last and are dropped
+
+	// 'features' selects the program, 'material' is a Material::getSortId(), 'primitive' a Primitive::sortId, 'depth' the
+	// view space distance
+	static std::uint64_t makeKey(RenderPass pass, unsigned int features, std::uint32_t material, std::uint32_t primitive, float depth);
+
+	void resize(std::size_t count); // Starts a new frame with 'count' packets to fill in
+	void sort();										// Radix sort by key, stable, then drops the kCulledKey slots and finds the batches
+
+	DrawPacket& operator[](std::size_t i) { return packets_[i]; }
+	std::vector<DrawPacket> const& getPackets() const { return packets_; }
+	std::size_t getPacketCount() const { return packets_.size(); }
+	std::vector<DrawBatch>& getBatches() { return batches_; }
+
+private:
+	void sortByKey_();
+
+	std::vector<DrawPacket> packets_;
+	std::vector<DrawPacket> scratch_; // Ping-pong buffer of the sort passes
+	std::vector<DrawBatch> batches_;
+};
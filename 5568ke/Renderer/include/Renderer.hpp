@@ -1,19 +1,30 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
 #include "BoundingBoxVisualizer.hpp"
+#include "DrawDataBuffer.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "FrustumCuller.hpp"
+#include "InstanceBuffer.hpp"
+#include "JointPaletteBuffer.hpp"
 #include "LightVisualizer.hpp"
+#include "RenderQueue.hpp"
+#include "Shader.hpp"
+#include "ShaderVariants.hpp"
 #include "SkeletonVisualizer.hpp"
 #include "SkyboxVisualizer.hpp"
 
+class Model;
 class Scene;
-class Shader;
+struct Pose;
 
 class Renderer {
 public:
@@ -28,6 +39,8 @@ public:
 	// Flag to control main visualization
 	bool showModels{true};
 	bool showWireFrame{false};
+	bool frustumCulling{true}; // Objects, then their meshes, then the clusters of large static meshes
+	bool instancing{true};		 // Objects sharing a model draw each primitive once for all of them
 
 	// Flag to control call visualizer
 	bool showSkybox{true};
@@ -40,6 +53,19 @@ public:
 	BoundingBoxVisualizer& boundingBoxVisualizerRef = BoundingBoxVisualizer::getInstance();
 	SkyboxVisualizer& skyboxVisualizerRef = SkyboxVisualizer::getInstance();
 
+	// Current frame stats
+	struct FrameStats {
+		int drawCalls{};
+		int instancedDraws{}; // Draw calls covering more than one object
+		int instances{};			// Objects drawn by those calls, counted per primitive
+		int visibleEntities{};
+		int paletteJoints{}; // Joint matrices uploaded for skinning
+		int culledObjects{};
+		int culledMeshes{};
+		int culledClusters{}; // Primitives of partly visible meshes, e.g. clusters of a large static mesh
+	};
+	FrameStats const& getFrameStats() const { return currentFrameStats_; }
+
 private:
 	Renderer() = default;
 	Renderer(Renderer const&) = delete;
@@ -47,21 +73,51 @@ private:
 
 	// Different shaders for different rendering techniques
 	std::unordered_map<std::string, std::shared_ptr<Shader>> shaders_;
-	std::shared_ptr<Shader> mainShader_;
-	std::shared_ptr<Shader> skinnedShader_;
+	ShaderVariants modelShaders_; // Every model is drawn with a permutation of model.vert / blinn.frag
+
+	// A visible scene object, with what the packet building threads read instead of the GameObject
+	struct ObjectDraw {
+		std::size_t sceneIndex{};
+		Model const* model{};
+		glm::mat4 const* transform{};
+		Pose const* pose{};
+		FrustumResult frustum{FRUSTUM_INSIDE}; // Its meshes are only tested when it intersects the frustum
+		int paletteOffset{-1};								 // First joint matrix in jointPalette_, -1 when it is not skinned
+		int firstDraw{};											 // Index of its first mesh's record in drawData_
+		std::size_t firstPacket{};						 // Index of its first primitive's packet in queue_
+		std::size_t packetCount{};						 // One per primitive, culled ones included
+
+		// Written by buildPackets_()
+		int culledMeshes{};
+		int culledClusters{};
+	};
 
 	// Helper methods for different rendering passes
 	void drawModels_(Scene const& scene);
-	void setupLighting_(Scene const& scene, std::shared_ptr<Shader> const& shader);
+	void setupFrame_(Scene const& scene);	 // Camera and lighting for every model shader through the 'Frame' block
+	void recordDraws_(Scene const& scene); // Joint palette, per-draw records and sorted packets of every visible object
+	// Runs on the worker threads, fills one object's records and packets
+	void buildPackets_(ObjectDraw& object, glm::mat4 const& view);
+	void recordInstances_(); // Instance data of every batch drawn instanced
+	void submitQueue_();
+
+	// Joint matrices of the frame's skinned objects, uploaded once per frame
+	JointPaletteBuffer jointPalette_;
+
+	// Uniform buffers shared by the model shaders, each uploaded once per frame
+	FrameUniformBuffer frameUniforms_;
+	DrawDataBuffer drawData_;
+
+	std::vector<ObjectDraw> objectDraws_;
+	Frustum frustum_;													 // Of the camera, for the frame being recorded
+	BoundsSoA objectBounds_;									 // World boxes of the frame's drawable objects
+	std::vector<FrustumResult> objectResults_; // Classification of objectBounds_
+	RenderQueue queue_;												 // One packet per primitive of the visible objects
+	InstanceBuffer instances_;								 // Matrices and palette offsets of the batches drawn instanced
 
 	// Renderer state
 	int viewportWidth_{};
 	int viewportHeight_{};
 
-	// Current frame stats
-	struct FrameStats {
-		int drawCalls{};
-		int visibleEntities{};
-	};
-	FrameStats currentFrameStats_;
+	FrameStats currentFrameStats_; // Reset by beginFrame()
 };
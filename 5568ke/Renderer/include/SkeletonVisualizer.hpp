@@ -6,8 +6,10 @@
 #include <unordered_map>
 #include <vector>
 
-class Shader;
+#include "Shader.hpp"
+
 class Node;
+struct Pose;
 class Model;
 class Camera;
 class GameObject;
@@ -33,12 +35,15 @@ private:
 	~SkeletonVisualizer() = default;
 
 	// Helper methods for visualization
-	void processNodeTreePositionsRecursive(std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors, float nodePosScale);
+	// Walks the model's node tree for names and children, positions come from the world matrices of 'pose'
+	void processNodeTreePositionsRecursive(std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors, float nodePosScale,
+																				 Pose const& pose);
 	void addDotJoint(glm::vec3 const& position, float radius, glm::vec3 const& color, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors);
 
 	// OpenGL resources
 	GLuint vao_{};
 	GLuint vbo_{};
+	UniformHandle<glm::mat4> viewLoc_, projLoc_, modelLoc_;
 	float jointRadius_{0.01f};
 
 	// Skeleton data
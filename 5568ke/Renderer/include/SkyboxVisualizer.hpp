@@ -6,9 +6,9 @@
 
 #include <glm/glm.hpp>
 
+#include "Shader.hpp"
 #include "include_5568ke.hpp"
 
-class Shader;
 class Scene;
 class Model;
 
@@ -43,6 +43,11 @@ private:
 	enum class SkyboxType { NONE, GLTF_MODEL, CUBEMAP };
 	SkyboxType skyboxType = SkyboxType::NONE;
 
+	// Uniforms of both shaders, resolved in init()
+	UniformHandle<glm::mat4> modelViewLoc_, modelProjLoc_, modelModelLoc_;
+	UniformHandle<glm::mat4> cubemapViewLoc_, cubemapProjLoc_;
+	UniformHandle<int> cubemapSamplerLoc_;
+
 	// Helper methods
 	bool createCubemapFromImages(std::vector<std::string> const& faceImages);
 	void setupCubemapMesh();
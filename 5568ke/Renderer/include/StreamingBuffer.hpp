@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "include_5568ke.hpp"
+
+/**
+ * @brief A GL buffer rewritten from scratch every frame. Storage grows with headroom and is orphaned before each upload,
+ * so the CPU never waits for draws of the previous frame. Shared by the per-frame buffers of the Renderer.
+ */
+class StreamingBuffer {
+public:
+	explicit StreamingBuffer(GLenum target) : target_(target) {}
+
+	void init();		// create the buffer
+	void cleanup(); // destroy GL objects
+
+	void upload(void const* data, std::size_t bytes); // Replaces the contents with 'bytes' bytes of 'data'
+
+	GLuint getBuffer() const { return buffer_; }
+	std::size_t getCapacityBytes() const { return capacity_; }
+
+private:
+	GLenum target_;
+	std::size_t capacity_{}; // Bytes allocated for the buffer, grows but never shrinks
+	GLuint buffer_{0};
+};
@@ -1,5 +1,6 @@
 #include "BoundingBoxVisualizer.hpp"
 
+#include "GLState.hpp"
 #include "Model.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
@@ -15,6 +16,10 @@ void BoundingBoxVisualizer::init()
 {
 	boxShader = std::make_shared<Shader>();
 	boxShader->resetShaderPath("assets/shaders/boundingBox.vert", "assets/shaders/boundingBox.frag");
+	viewLoc_ = boxShader->getUniform<glm::mat4>("view");
+	projLoc_ = boxShader->getUniform<glm::mat4>("proj");
+	modelLoc_ = boxShader->getUniform<glm::mat4>("model");
+	colorLoc_ = boxShader->getUniform<glm::vec3>("uColor");
 
 	glGenVertexArrays(1, &vao_);
 	glGenBuffers(1, &vbo_);
@@ -88,24 +93,22 @@ void BoundingBoxVisualizer::draw(Scene const& scene)
 		return;
 
 	// upload once per frame
-	glBindVertexArray(vao_);
+	GLState& state = GLState::getInstance();
+	state.bindVertexArray(vao_);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(glm::vec3), verts.data(), GL_DYNAMIC_DRAW);
 
 	// simple colour – bright magenta
 	boxShader->bind();
-	boxShader->sendMat4("view", scene.cam.view);
-	boxShader->sendMat4("proj", scene.cam.proj);
-	boxShader->sendMat4("model", glm::mat4(1.0f));
-	boxShader->sendVec3("uColor", glm::vec3(1, 1, 1));
+	boxShader->set(viewLoc_, scene.cam.view);
+	boxShader->set(projLoc_, scene.cam.proj);
+	boxShader->set(modelLoc_, glm::mat4(1.0f));
+	boxShader->set(colorLoc_, glm::vec3(1, 1, 1));
 
-	GLboolean depth;
-	glGetBooleanv(GL_DEPTH_TEST, &depth);
-	glDisable(GL_DEPTH_TEST);
+	bool depth = state.isEnabled(GL_DEPTH_TEST);
+	state.setEnabled(GL_DEPTH_TEST, false);
 
 	glDrawArrays(GL_LINES, 0, (GLsizei)verts.size());
 
-	if (depth)
-		glEnable(GL_DEPTH_TEST);
-	glBindVertexArray(0);
+	state.setEnabled(GL_DEPTH_TEST, depth);
 }
@@ -0,0 +1,49 @@
+#include "DrawDataBuffer.hpp"
+
+#include <cstring>
+
+void DrawDataBuffer::init()
+{
+	buffer_.init();
+
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	std::size_t align = alignment > 0 ? static_cast<std::size_t>(alignment) : 256;
+	stride_ = (sizeof(DrawBlock) + align - 1) / align * align;
+}
+
+void DrawDataBuffer::cleanup() { buffer_.cleanup(); }
+
+void DrawDataBuffer::clear() { staging_.clear(); }
+
+int DrawDataBuffer::append(DrawBlock const& draw)
+{
+	int index = static_cast<int>(getDrawCount());
+	std::size_t offset = staging_.size();
+	staging_.resize(offset + stride_);
+	std::memcpy(staging_.data() + offset, &draw, sizeof(DrawBlock));
+	return index;
+}
+
+int DrawDataBuffer::append(std::size_t count)
+{
+	int index = static_cast<int>(getDrawCount());
+	staging_.resize(staging_.size() + count * stride_);
+	return index;
+}
+
+void DrawDataBuffer::set(int draw, DrawBlock const& block) { std::memcpy(staging_.data() + draw * stride_, &block, sizeof(DrawBlock)); }
+
+DrawBlock DrawDataBuffer::get(int draw) const
+{
+	DrawBlock block;
+	std::memcpy(&block, staging_.data() + draw * stride_, sizeof(DrawBlock));
+	return block;
+}
+
+void DrawDataBuffer::upload() { buffer_.upload(staging_.data(), staging_.size()); }
+
+void DrawDataBuffer::bind(int draw) const
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, DrawBlock::kBinding, buffer_.getBuffer(), static_cast<GLintptr>(draw * stride_), sizeof(DrawBlock));
+}
@@ -0,0 +1,27 @@
+#include "FrameUniformBuffer.hpp"
+
+void FrameUniformBuffer::init()
+{
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniformBuffer::cleanup()
+{
+	if (buffer_)
+		glDeleteBuffers(1, &buffer_);
+	buffer_ = 0;
+}
+
+void FrameUniformBuffer::upload(FrameBlock const& frame)
+{
+	if (!buffer_)
+		return;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FrameBlock::kBinding, buffer_);
+}
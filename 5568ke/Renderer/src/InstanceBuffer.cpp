@@ -0,0 +1,15 @@
+#include "InstanceBuffer.hpp"
+
+void InstanceBuffer::init() { buffer_.init(); }
+
+void InstanceBuffer::cleanup() { buffer_.cleanup(); }
+
+void InstanceBuffer::clear() { staging_.clear(); }
+
+int InstanceBuffer::append(InstanceData const& instance)
+{
+	staging_.push_back(instance);
+	return static_cast<int>(staging_.size() - 1);
+}
+
+void InstanceBuffer::upload() { buffer_.upload(staging_.data(), staging_.size() * sizeof(InstanceData)); }
@@ -0,0 +1,39 @@
+#include "JointPaletteBuffer.hpp"
+
+#include "GLState.hpp"
+#include "PosePool.hpp"
+
+void JointPaletteBuffer::init()
+{
+	buffer_.init();
+	glGenTextures(1, &texture_);
+
+	// Each matrix is four RGBA32F texels, one per column
+	glBindTexture(GL_TEXTURE_BUFFER, texture_);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer_.getBuffer());
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void JointPaletteBuffer::cleanup()
+{
+	if (texture_)
+		glDeleteTextures(1, &texture_);
+	texture_ = 0;
+	buffer_.cleanup();
+}
+
+void JointPaletteBuffer::clear() { staging_.clear(); }
+
+int JointPaletteBuffer::append(Pose const& pose)
+{
+	int offset = static_cast<int>(staging_.size());
+	staging_.insert(staging_.end(), pose.jointMatrices, pose.jointMatrices + pose.jointCount);
+	return offset;
+}
+
+void JointPaletteBuffer::upload() { buffer_.upload(staging_.data(), staging_.size() * sizeof(glm::mat4)); }
+
+void JointPaletteBuffer::bind() const
+{
+	GLState::getInstance().bindTexture(kTextureUnit, GL_TEXTURE_BUFFER, texture_);
+}
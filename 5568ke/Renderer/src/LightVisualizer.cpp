@@ -1,5 +1,6 @@
 #include "LightVisualizer.hpp"
 
+#include "GLState.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
 #include "include_5568ke.hpp"
@@ -14,6 +15,9 @@ void LightPointVisualizer::init()
 {
 	lightPointShader = std::make_unique<Shader>();
 	lightPointShader->resetShaderPath("assets/shaders/point.vert", "assets/shaders/point.frag");
+	viewLoc_ = lightPointShader->getUniform<glm::mat4>("view");
+	projLoc_ = lightPointShader->getUniform<glm::mat4>("proj");
+	pointSizeLoc_ = lightPointShader->getUniform<float>("pointSize");
 
 	glEnable(GL_PROGRAM_POINT_SIZE);
 	glGenVertexArrays(1, &vao_);
@@ -43,23 +47,21 @@ void LightPointVisualizer::draw(Scene const& scene)
 	for (auto const& l : scene.lights)
 		pts.emplace_back(l.position);
 
-	glBindVertexArray(vao_);
+	GLState& state = GLState::getInstance();
+	state.bindVertexArray(vao_);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 	glBufferData(GL_ARRAY_BUFFER, pts.size() * sizeof(glm::vec3), pts.data(), GL_DYNAMIC_DRAW);
 
 	lightPointShader->bind();
-	lightPointShader->sendMat4("view", scene.cam.view);
-	lightPointShader->sendMat4("proj", scene.cam.proj);
-	lightPointShader->sendFloat("pointSize", 50.0f); // see lightPointShader below
+	lightPointShader->set(viewLoc_, scene.cam.view);
+	lightPointShader->set(projLoc_, scene.cam.proj);
+	lightPointShader->set(pointSizeLoc_, 50.0f); // see lightPointShader below
 
 	// disable depth just like skeleton (so gizmos are always visible)
-	GLboolean depth;
-	glGetBooleanv(GL_DEPTH_TEST, &depth);
-	glDisable(GL_DEPTH_TEST);
+	bool depth = state.isEnabled(GL_DEPTH_TEST);
+	state.setEnabled(GL_DEPTH_TEST, false);
 
 	glDrawArrays(GL_POINTS, 0, (GLsizei)pts.size());
 
-	if (depth)
-		glEnable(GL_DEPTH_TEST);
-	glBindVertexArray(0);
+	state.setEnabled(GL_DEPTH_TEST, depth);
 }
@@ -0,0 +1,87 @@
+#include "RenderQueue.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t fieldMask(int bits) { return (std::uint64_t{1} << bits) - 1; }
+
+} // namespace
+
+std::uint64_t RenderQueue::makeKey(RenderPass pass, unsigned int features, std::uint32_t material, std::uint32_t primitive, float depth)
+{
+	static_assert(kPassBits + kProgramBits + kMaterialBits + kPrimitiveBits + kDepthBits == 64, "Sort key fields must fill 64 bits");
+
+	// Non-negative floats order like their bit patterns, anything behind the camera (or NaN) sorts first. The top bits
+	// keep the exponent and the leading mantissa bits, plenty to order instances front to back
+	depth = depth > 0.0f ? depth : 0.0f;
+	std::uint32_t depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	std::uint64_t key = static_cast<std::uint64_t>(pass) & fieldMask(kPassBits);
+	key = (key << kProgramBits) | (features & fieldMask(kProgramBits));
+	key = (key << kMaterialBits) | (material & fieldMask(kMaterialBits));
+	key = (key << kPrimitiveBits) | (primitive & fieldMask(kPrimitiveBits));
+	key = (key << kDepthBits) | (depthBits >> (32 - kDepthBits));
+	return key;
+}
+
+void RenderQueue::resize(std::size_t count) { packets_.resize(count); }
+
+void RenderQueue::sort()
+{
+	sortByKey_();
+
+	// No real key has both pass bits set, so the culled slots are the tail
+	while (!packets_.empty() && packets_.back().key == kCulledKey)
+		packets_.pop_back();
+
+	// Runs of the same primitive and permutation. Ids are truncated in the key, so the packets themselves are compared
+	batches_.clear();
+	for (std::size_t i = 0; i < packets_.size(); ++i) {
+		DrawPacket const& packet = packets_[i];
+		if (!batches_.empty()) {
+			DrawPacket const& first = packets_[batches_.back().firstPacket];
+			if (first.primitive == packet.primitive && first.features == packet.features) {
+				++batches_.back().packetCount;
+				continue;
+			}
+		}
+		batches_.push_back(DrawBatch{i, 1});
+	}
+}
+
+void RenderQueue::sortByKey_()
+{
+	std::size_t count = packets_.size();
+	if (count < 2)
+		return;
+
+	// Least significant byte first. One pass over the keys counts the digits of all eight bytes
+	constexpr int kDigits = 8;
+	std::size_t counts[kDigits][256] = {};
+	for (DrawPacket const& packet : packets_) {
+		for (int d = 0; d < kDigits; ++d)
+			++counts[d][(packet.key >> (d * 8)) & 0xFF];
+	}
+
+	scratch_.resize(count);
+	for (int d = 0; d < kDigits; ++d) {
+		std::size_t* offsets = counts[d];
+
+		// A byte every key shares would not move anything, e.g. the pass bits of a frame without double-sided primitives
+		if (offsets[(packets_[0].key >> (d * 8)) & 0xFF] == count)
+			continue;
+
+		std::size_t offset = 0;
+		for (int b = 0; b < 256; ++b) {
+			std::size_t digitCount = offsets[b];
+			offsets[b] = offset;
+			offset += digitCount;
+		}
+
+		for (DrawPacket const& packet : packets_)
+			scratch_[offsets[(packet.key >> (d * 8)) & 0xFF]++] = packet;
+		packets_.swap(scratch_);
+	}
+}
@@ -2,15 +2,35 @@
 
 #include "Renderer.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "AnimationInstance.hpp"
+#include "AnimationSystem.hpp"
+#include "Mesh.hpp"
+#include "GLState.hpp"
+#include "Material.hpp"
 #include "Model.hpp"
+#include "ProgramCache.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
 #include "include_5568ke.hpp"
 
+namespace {
+
+// Per worker thread, reused by every object it builds packets for
+struct CullScratch {
+	std::vector<glm::mat4> transforms; // Per mesh
+	BoundsSoA bounds;
+	std::vector<FrustumResult> meshResults;
+	std::vector<FrustumResult> primitiveResults;
+};
+thread_local CullScratch t_cullScratch;
+
+} // namespace
+
 Renderer& Renderer::getInstance()
 {
 	static Renderer instance;
@@ -19,19 +39,20 @@ Renderer& Renderer::getInstance()
 
 void Renderer::init()
 {
-	// Create default shaders
-	auto blinnPhongShader = std::make_unique<Shader>();
-	blinnPhongShader->resetShaderPath("assets/shaders/blinn.vert", "assets/shaders/blinn.frag");
-	shaders_["blinn"] = std::move(blinnPhongShader);
-
-	// Create skinned shader for animated models
-	auto skinnedShader = std::make_unique<Shader>();
-	skinnedShader->resetShaderPath("assets/shaders/skinned.vert", "assets/shaders/blinn.frag");
-	shaders_["skinned"] = std::move(skinnedShader);
-
-	// Set default main shader
-	mainShader_ = shaders_["blinn"];
-	skinnedShader_ = shaders_["skinned"];
+	// Compile or load every program before waiting on any of them, see ProgramCache
+	ProgramCache& programCache = ProgramCache::getInstance();
+	programCache.beginBatch();
+
+	// Model shaders, permutations are compiled as draws ask for them. The common ones are compiled up front so the first
+	// frames do not stall on them
+	modelShaders_.resetShaderPath("assets/shaders/model.vert", "assets/shaders/blinn.frag");
+	modelShaders_.setSamplerUnit("tex0", 0); // Materials bind their textures to the first units
+	modelShaders_.setSamplerUnit("tex1", 1);
+	modelShaders_.setSamplerUnit("jointPalette", JointPaletteBuffer::kTextureUnit);
+	modelShaders_.get(0);
+	modelShaders_.get(SHADER_SKINNING);
+	modelShaders_.get(SHADER_INSTANCING);
+	modelShaders_.get(SHADER_SKINNING | SHADER_INSTANCING);
 
 	// Initialize skeleton visualizer
 	skeletonVisualizerRef.init();
@@ -50,6 +71,13 @@ void Renderer::init()
 	shaders_["skybox_model"] = skyboxVisualizerRef.skyboxShader;
 	shaders_["skybox_cubemap"] = skyboxVisualizerRef.cubemapShader;
 	// std::cout << "[Renderer] SkyboxVisualizer initialized" << std::endl;
+
+	programCache.endBatch();
+
+	jointPalette_.init();
+	frameUniforms_.init();
+	drawData_.init();
+	instances_.init();
 }
 
 void Renderer::beginFrame(int w, int h, glm::vec3 const& c)
@@ -59,12 +87,16 @@ void Renderer::beginFrame(int w, int h, glm::vec3 const& c)
 
 	glViewport(0, 0, w, h);
 
+	// Loading and ImGui changed GL state since the last frame, start the tracker from scratch
+	GLState& state = GLState::getInstance();
+	state.beginFrame();
+
 	// Enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	state.setEnabled(GL_DEPTH_TEST, true);
 
 	// Enable face culling to improve performance and avoid interior fragments
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	state.setEnabled(GL_CULL_FACE, true);
+	state.cullFace(GL_BACK);
 
 	// Clear the screen
 	glClearColor(c.r, c.g, c.b, 1.0f);
@@ -91,87 +123,278 @@ void Renderer::drawScene(Scene const& scene)
 
 void Renderer::drawModels_(Scene const& scene)
 {
-	if (!mainShader_)
-		return;
+	setupFrame_(scene);
+	recordDraws_(scene);
+	jointPalette_.bind();
+
+	GLState::getInstance().polygonMode(showWireFrame ? GL_LINE : GL_FILL);
+	submitQueue_();
+
+	// Draw skeletons if enabled, as debug visualization on top of the models
+	if (showSkeletons) {
+		for (ObjectDraw const& object : objectDraws_) {
+			GameObject const& gameObject = *scene.gameObjects[object.sceneIndex];
+			if (skeletonVisualizerRef.hasSkeletonData(gameObject.getModel()))
+				skeletonVisualizerRef.draw(gameObject, scene.cam);
+		}
+	}
 
-	// Bind the main shader
-	mainShader_->bind();
+	// Update stats, an instanced batch is one call for all of its packets
+	currentFrameStats_.drawCalls += static_cast<int>(queue_.getPacketCount()) - currentFrameStats_.instances + currentFrameStats_.instancedDraws;
+	currentFrameStats_.visibleEntities += static_cast<int>(objectDraws_.size());
+}
 
-	// Set camera-related uniforms
-	mainShader_->sendMat4("view", scene.cam.view);
-	mainShader_->sendMat4("proj", scene.cam.proj);
+void Renderer::setupFrame_(Scene const& scene)
+{
+	FrameBlock frame;
+	frame.view = scene.cam.view;
+	frame.proj = scene.cam.proj;
+	frame.viewPos = glm::vec4(scene.cam.pos, 1.0f);
 
-	// Setup lighting
-	setupLighting_(scene, mainShader_);
+	// This implementation assumes a simple lighting model like in the original code
+	if (!scene.lights.empty())
+		frame.lightPos = glm::vec4(scene.lights[0].position, 1.0f);
 
-	// If we have a skinned shader, set up its uniforms too
-	if (skinnedShader_) {
-		skinnedShader_->bind();
-		skinnedShader_->sendMat4("view", scene.cam.view);
-		skinnedShader_->sendMat4("proj", scene.cam.proj);
-		setupLighting_(scene, skinnedShader_);
-	}
+	frameUniforms_.upload(frame);
+}
 
-	// Draw all visible entities
+void Renderer::recordDraws_(Scene const& scene)
+{
+	// Pack the joint matrices of every skinned object into the palette and reserve the draw records and packets of every
+	// visible object. Only this pass touches the scene's shared pointers
+	jointPalette_.clear();
+	drawData_.clear();
+	objectDraws_.clear();
+
+	// Object level, the world boxes of every drawable object in one batch
+	frustum_ = Frustum(scene.cam.proj * scene.cam.view);
+	objectBounds_.clear();
 	for (auto const& goPtr : scene.gameObjects) {
+		if (goPtr && goPtr->visible && goPtr->getModel())
+			objectBounds_.push(goPtr->worldBBox);
+	}
+	objectResults_.assign(objectBounds_.size(), FRUSTUM_INSIDE);
+	if (frustumCulling) {
+		std::size_t visible = frustum_.classify(objectBounds_, objectResults_.data());
+		currentFrameStats_.culledObjects += static_cast<int>(objectBounds_.size() - visible);
+	}
+
+	std::size_t packetCount = 0;
+	std::size_t candidate = 0;
+	for (std::size_t i = 0; i < scene.gameObjects.size(); ++i) {
+		auto const& goPtr = scene.gameObjects[i];
 		if (!goPtr || !goPtr->visible || !goPtr->getModel())
 			continue;
 
-		GameObject& gameObject = *goPtr;
-		if (showWireFrame) {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		}
-		else {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		}
+		FrustumResult frustum = objectResults_[candidate++];
+		if (frustum == FRUSTUM_OUTSIDE)
+			continue;
 
-		// Choose shader based on if the model has joint matrices
-		Shader const* shaderToUse = mainShader_.get();
+		ObjectDraw object;
+		object.sceneIndex = i;
+		object.model = goPtr->getModel().get();
+		object.transform = &goPtr->getTransform();
+		object.frustum = frustum;
+
+		// Objects without clips use the model's bind pose
+		Model const& model = *object.model;
+		object.pose = goPtr->hasAnimation() ? &goPtr->getAnimation()->getPose() : &model.bindPose.get();
+		if (model.jointCount > 0 && !model.animations.empty() && object.pose->jointCount > 0)
+			object.paletteOffset = jointPalette_.append(*object.pose);
+
+		object.firstDraw = drawData_.append(model.meshes.size());
+		object.firstPacket = packetCount;
+		for (auto const& mesh : model.meshes)
+			object.packetCount += mesh.primitives.size();
+		packetCount += object.packetCount;
+
+		objectDraws_.push_back(object);
+	}
 
-		if (skinnedShader_ && !gameObject.getModel()->jointMatrices.empty() && gameObject.getModel()->animations.size() > 0)
-			shaderToUse = skinnedShader_.get();
+	// Matrices, mesh and cluster culling and packets of each object are independent, the workers fill the slots reserved above
+	queue_.resize(packetCount);
+	glm::mat4 const view = scene.cam.view;
+	AnimationSystem::getInstance().parallelFor(objectDraws_.size(), [&](std::size_t o) { buildPackets_(objectDraws_[o], view); });
+	queue_.sort();
+	recordInstances_();
 
-		shaderToUse->bind();																									// Bind the appropriate shader
-		gameObject.getModel()->draw(*shaderToUse, gameObject.getTransform()); // Draw the model with the scaled model matrix
+	for (ObjectDraw const& object : objectDraws_) {
+		currentFrameStats_.culledMeshes += object.culledMeshes;
+		currentFrameStats_.culledClusters += object.culledClusters;
+	}
 
-		if (skeletonVisualizerRef.hasSkeletonData(gameObject.getModel())) {
+	jointPalette_.upload();
+	drawData_.upload();
+	instances_.upload();
+	currentFrameStats_.paletteJoints = static_cast<int>(jointPalette_.getJointCount());
+}
 
-			// Draw skeleton if enabled
-			if (showSkeletons) {
-				// Draw debug visualization
-				skeletonVisualizerRef.draw(gameObject, scene.cam);
+void Renderer::buildPackets_(ObjectDraw& object, glm::mat4 const& view)
+{
+	Model const& model = *object.model;
+	CullScratch& scratch = t_cullScratch;
+
+	DrawBlock draw;
+	draw.skinning = glm::ivec4(std::max(object.paletteOffset, 0), 0, 0, 0);
+
+	scratch.transforms.resize(model.meshes.size());
+	scratch.bounds.clear();
+	for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+		draw.model = model.getMeshTransform(m, *object.transform, *object.pose);
+		draw.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(draw.model))));
+		drawData_.set(object.firstDraw + static_cast<int>(m), draw);
+		scratch.transforms[m] = draw.model;
+
+		if (object.frustum == FRUSTUM_INTERSECTS && m < model.boundingBoxes.size())
+			scratch.bounds.push(BBoxUtil::transformBBox(model.boundingBoxes[m], draw.model));
+	}
 
-				// Rebind main shader after drawing lines
-				mainShader_->bind();
-			}
+	// Mesh level, only for objects crossing the frustum. Skinned meshes move away from their load-time boxes when drawn with
+	// the palette, the object's animated box is all that bounds them
+	scratch.meshResults.assign(model.meshes.size(), object.frustum);
+	if (scratch.bounds.size() > 0)
+		frustum_.classify(scratch.bounds, scratch.meshResults.data());
+	for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+		if (object.paletteOffset >= 0 && model.meshes[m].isSkinned())
+			scratch.meshResults[m] = object.frustum;
+	}
+
+	// Objects with joint matrices in the palette use the skinning permutation, primitives and materials add their own features
+	unsigned int objectFeatures = object.paletteOffset >= 0 ? SHADER_SKINNING : 0u;
+
+	std::size_t packet = object.firstPacket;
+	for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+		Mesh const& mesh = model.meshes[m];
+		if (scratch.meshResults[m] == FRUSTUM_OUTSIDE) {
+			++object.culledMeshes;
+			continue;
+		}
+
+		// Cluster level, the primitives of meshes crossing the frustum. Clustered large static meshes have many
+		glm::mat4 const& transform = scratch.transforms[m];
+		scratch.primitiveResults.assign(mesh.primitives.size(), FRUSTUM_INSIDE);
+		if (scratch.meshResults[m] == FRUSTUM_INTERSECTS && mesh.primitives.size() > 1 && !(object.paletteOffset >= 0 && mesh.isSkinned())) {
+			scratch.bounds.clear();
+			for (Primitive const& prim : mesh.primitives)
+				scratch.bounds.push(BBoxUtil::transformBBox(prim.bounds, transform));
+			std::size_t visible = frustum_.classify(scratch.bounds, scratch.primitiveResults.data());
+			object.culledClusters += static_cast<int>(mesh.primitives.size() - visible);
 		}
 
-		// Update stats
-		currentFrameStats_.drawCalls++;
-		currentFrameStats_.visibleEntities++;
+		// Distance along the view direction of the mesh's origin
+		float depth = -(view * transform[3]).z;
+		int record = object.firstDraw + static_cast<int>(m);
+
+		for (std::size_t p = 0; p < mesh.primitives.size(); ++p) {
+			if (scratch.primitiveResults[p] == FRUSTUM_OUTSIDE)
+				continue;
+
+			Primitive const& prim = mesh.primitives[p];
+			unsigned int features = objectFeatures;
+			if (prim.doubleSided)
+				features |= SHADER_DOUBLE_SIDED;
+			if (prim.material)
+				features |= prim.material->getShaderFeatures();
+
+			RenderPass pass = prim.doubleSided ? RenderPass::DOUBLE_SIDED : RenderPass::SOLID;
+			std::uint32_t material = prim.material ? prim.material->getSortId() : 0u;
+			queue_[packet++] = DrawPacket{RenderQueue::makeKey(pass, features, material, prim.sortId, depth), &mesh, &prim, record, features};
+		}
 	}
+
+	// Slots of culled primitives stay reserved, sort() drops them
+	for (; packet < object.firstPacket + object.packetCount; ++packet)
+		queue_[packet] = DrawPacket{RenderQueue::kCulledKey, nullptr, nullptr, -1, 0};
 }
 
-void Renderer::setupLighting_(Scene const& scene, std::shared_ptr<Shader> const& shader)
+void Renderer::recordInstances_()
 {
-	if (!shader)
+	// Batches of one packet keep their draw record, the others copy each packet's record into the instance buffer
+	instances_.clear();
+	if (!instancing)
 		return;
 
-	// Set light positions and properties
-	// This implementation assumes a simple lighting model like in the original code
-	if (!scene.lights.empty()) {
-		shader->sendVec3("lightPos", scene.lights[0].position);
-		// shader->sendVec3("lightColor", scene.lights[0].color);
-		// shader->sendFloat("lightIntensity", scene.lights[0].intensity);
+	std::vector<DrawPacket> const& packets = queue_.getPackets();
+	for (DrawBatch& batch : queue_.getBatches()) {
+		if (batch.packetCount < 2)
+			continue;
+
+		for (std::size_t p = batch.firstPacket; p < batch.firstPacket + batch.packetCount; ++p) {
+			DrawBlock draw = drawData_.get(packets[p].drawRecord);
+			InstanceData instance;
+			instance.model = draw.model;
+			for (int c = 0; c < 3; ++c)
+				instance.normalMatrix[c] = glm::vec3(draw.normalMatrix[c]);
+			instance.paletteOffset = draw.skinning.x;
+
+			int index = instances_.append(instance);
+			if (p == batch.firstPacket)
+				batch.firstInstance = index;
+		}
+		currentFrameStats_.instancedDraws++;
+		currentFrameStats_.instances += batch.packetCount;
 	}
+}
+
+void Renderer::submitQueue_()
+{
+	// Packets are sorted, so each kind of state only changes at the boundaries of its runs
+	GLState& state = GLState::getInstance();
+	bool cull = state.isEnabled(GL_CULL_FACE);
+
+	Shader const* shader = nullptr;
+	unsigned int features = 0;
+	Mesh const* mesh = nullptr;
+	Material const* material = nullptr;
+	int record = -1;
+
+	std::vector<DrawPacket> const& packets = queue_.getPackets();
+	for (DrawBatch const& batch : queue_.getBatches()) {
+		DrawPacket const& packet = packets[batch.firstPacket];
+		bool instanced = batch.firstInstance >= 0;
+
+		unsigned int batchFeatures = packet.features | (instanced ? SHADER_INSTANCING : 0u);
+		if (!shader || batchFeatures != features) {
+			features = batchFeatures;
+			shader = &modelShaders_.get(features);
+			shader->bind();
+			material = nullptr; // A material may set program state as well
+		}
+		if (packet.mesh != mesh) {
+			mesh = packet.mesh;
+			mesh->bind();
+		}
 
-	shader->sendVec3("viewPos", scene.cam.pos);
+		Primitive const& prim = *packet.primitive;
+		if (prim.material && prim.material != material) {
+			material = prim.material;
+			material->bind(*shader);
+		}
+		state.setEnabled(GL_CULL_FACE, cull && !prim.doubleSided);
+
+		// Instanced draws read their matrices from the instance attributes, the others select each packet's draw record
+		if (instanced) {
+			mesh->bindInstances(instances_.getBuffer(), batch.firstInstance * sizeof(InstanceData));
+			mesh->drawPrimitive(prim, batch.packetCount);
+			continue;
+		}
+		for (std::size_t p = batch.firstPacket; p < batch.firstPacket + batch.packetCount; ++p) {
+			if (packets[p].drawRecord != record) {
+				record = packets[p].drawRecord;
+				drawData_.bind(record);
+			}
+			mesh->drawPrimitive(prim);
+		}
+	}
+	state.setEnabled(GL_CULL_FACE, cull);
 }
 
 void Renderer::endFrame()
 {
-	glBindVertexArray(0);
-	glUseProgram(0);
+	GLState& state = GLState::getInstance();
+	state.polygonMode(GL_FILL); // ImGui draws after the scene
+	state.bindVertexArray(0);
+	state.useProgram(0);
 }
 
 void Renderer::cleanup()
@@ -181,4 +404,8 @@ void Renderer::cleanup()
 	lightVisualizerRef.cleanup();
 	boundingBoxVisualizerRef.cleanup();
 	skyboxVisualizerRef.cleanup();
+	jointPalette_.cleanup();
+	frameUniforms_.cleanup();
+	drawData_.cleanup();
+	instances_.cleanup();
 }
@@ -4,6 +4,8 @@
 
 #include <iostream>
 
+#include "AnimationInstance.hpp"
+#include "GLState.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
 #include "Renderer.hpp"
@@ -21,6 +23,9 @@ void SkeletonVisualizer::init()
 	// Create line shader for debug visualization
 	skeletonShader = std::make_unique<Shader>();
 	skeletonShader->resetShaderPath("assets/shaders/skeleton.vert", "assets/shaders/skeleton.frag");
+	viewLoc_ = skeletonShader->getUniform<glm::mat4>("view");
+	projLoc_ = skeletonShader->getUniform<glm::mat4>("proj");
+	modelLoc_ = skeletonShader->getUniform<glm::mat4>("model");
 
 	// Create OpenGL resources
 	glGenVertexArrays(1, &vao_);
@@ -90,7 +95,7 @@ void SkeletonVisualizer::generateSkeletonData(std::shared_ptr<Model> model)
 
 	// Process the node hierarchy recursively starting from the root
 	float nodePosScale = 0.005f;
-	processNodeTreePositionsRecursive(model->rootNode, skeletonData.vertices, skeletonData.colors, nodePosScale);
+	processNodeTreePositionsRecursive(model->rootNode, skeletonData.vertices, skeletonData.colors, nodePosScale, model->bindPose.get());
 
 	// std::cout << "[SkeletonVisualizer] Generated " << skeletonData.vertices.size() << " vertices for skeleton lines" << std::endl;
 
@@ -99,20 +104,26 @@ void SkeletonVisualizer::generateSkeletonData(std::shared_ptr<Model> model)
 }
 
 void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors,
-																													 float nodePosScale)
+																													 float nodePosScale, Pose const& pose)
 {
 	if (!node)
 		return;
 
+	auto matrixOf = [&pose](Node const& n) {
+		if (n.nodeNum >= 0 && static_cast<std::size_t>(n.nodeNum) < pose.nodeCount)
+			return glm::mat4(pose.worldMatrices[n.nodeNum]);
+		return glm::mat4(1.0f);
+	};
+
 	// Get node position
-	glm::mat4 nodeMatrix = node->getNodeMatrix();
+	glm::mat4 nodeMatrix = matrixOf(*node);
 	glm::vec3 nodePos = glm::vec3(nodeMatrix[3]);
 
 	// Skip nodes with zero position (might be invalid)
 	if (glm::length(nodePos) < 0.001f) {
 		// Process children anyway
 		for (auto& child : node->children) {
-			processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale);
+			processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale, pose);
 		}
 		return;
 	}
@@ -148,7 +159,7 @@ void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node>
 		if (!child)
 			continue;
 
-		glm::mat4 childMatrix = child->getNodeMatrix();
+		glm::mat4 childMatrix = matrixOf(*child);
 		glm::vec3 childPos = glm::vec3(childMatrix[3]);
 
 		// Only draw connections to nodes with valid positions
@@ -169,7 +180,7 @@ void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node>
 
 	// Process children recursively
 	for (auto& child : node->children) {
-		processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale);
+		processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale, pose);
 	}
 }
 
@@ -196,7 +207,8 @@ void SkeletonVisualizer::draw(GameObject const& gameObject, Camera const& cam)
 	if (model->rootNode) {
 		// Use the same scale factor for skeleton as for the model
 		float nodePosScale = 1.0f; // This will be applied with the model matrix
-		processNodeTreePositionsRecursive(model->rootNode, vertices, colors, nodePosScale);
+		Pose const& pose = gameObject.hasAnimation() ? gameObject.getAnimation()->getPose() : model->bindPose.get();
+		processNodeTreePositionsRecursive(model->rootNode, vertices, colors, nodePosScale, pose);
 	}
 
 	// Skip if no vertices
@@ -218,38 +230,34 @@ void SkeletonVisualizer::draw(GameObject const& gameObject, Camera const& cam)
 	}
 
 	// Update buffer data
-	glBindVertexArray(vao_);
+	GLState& state = GLState::getInstance();
+	state.bindVertexArray(vao_);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 	glBufferData(GL_ARRAY_BUFFER, interleavedData.size() * sizeof(glm::vec3), interleavedData.data(), GL_DYNAMIC_DRAW);
 
 	// Bind shader and set uniforms
 	skeletonShader->bind();
-	skeletonShader->sendMat4("view", cam.view);
-	skeletonShader->sendMat4("proj", cam.proj);
-	skeletonShader->sendMat4("model", gameObject.getTransform());
+	skeletonShader->set(viewLoc_, cam.view);
+	skeletonShader->set(projLoc_, cam.proj);
+	skeletonShader->set(modelLoc_, gameObject.getTransform());
 
 	// Draw lines with wider lines for better visibility
-	glLineWidth(3.0f); // Make lines thicker
+	state.lineWidth(3.0f); // Make lines thicker
 
 	// Disable depth testing temporarily to ensure skeleton is visible
-	GLboolean depthTestEnabled;
-	glGetBooleanv(GL_DEPTH_TEST, &depthTestEnabled);
+	bool depthTestEnabled = state.isEnabled(GL_DEPTH_TEST);
 
 	// Draw once with depth test to place lines correctly
 	glDrawArrays(GL_LINES, 0, vertices.size());
 
 	// Draw again without depth test to ensure visibility
-	glDisable(GL_DEPTH_TEST);
+	state.setEnabled(GL_DEPTH_TEST, false);
 	glDrawArrays(GL_LINES, 0, vertices.size());
 
 	// Restore original depth test state
-	if (depthTestEnabled)
-		glEnable(GL_DEPTH_TEST);
+	state.setEnabled(GL_DEPTH_TEST, depthTestEnabled);
 
-	glLineWidth(1.0f); // Reset line width
-
-	// Unbind
-	glBindVertexArray(0);
+	state.lineWidth(1.0f); // Reset line width
 }
 
 void SkeletonVisualizer::addDotJoint(glm::vec3 const& position, float radius, glm::vec3 const& color, std::vector<glm::vec3>& vertices,
@@ -8,6 +8,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "GLState.hpp"
 #include "Model.hpp"
 #include "ModelRegistry.hpp"
 #include "Scene.hpp"
@@ -24,10 +25,18 @@ void SkyboxVisualizer::init()
 	// Create skybox shader for GLTF models
 	skyboxShader = std::make_shared<Shader>();
 	skyboxShader->resetShaderPath("assets/shaders/skybox_model.vert", "assets/shaders/skybox_model.frag");
+	skyboxShader->setSamplerUnit("tex0", 0); // Bound by the model's materials
+	skyboxShader->setSamplerUnit("tex1", 1);
+	modelViewLoc_ = skyboxShader->getUniform<glm::mat4>("view");
+	modelProjLoc_ = skyboxShader->getUniform<glm::mat4>("proj");
+	modelModelLoc_ = skyboxShader->getUniform<glm::mat4>("model");
 
 	// Create cubemap shader
 	cubemapShader = std::make_shared<Shader>();
 	cubemapShader->resetShaderPath("assets/shaders/skybox.vert", "assets/shaders/skybox.frag");
+	cubemapViewLoc_ = cubemapShader->getUniform<glm::mat4>("view");
+	cubemapProjLoc_ = cubemapShader->getUniform<glm::mat4>("proj");
+	cubemapSamplerLoc_ = cubemapShader->getUniform<int>("skybox");
 
 	// std::cout << "[SkyboxVisualizer] Initialized with custom skybox shaders" << std::endl;
 
@@ -133,26 +142,20 @@ void SkyboxVisualizer::draw(Scene const& scene)
 	}
 
 	if (skyboxType == SkyboxType::GLTF_MODEL && skyboxModel) {
-		// Save current GL state
-		GLboolean depthTest;
-		glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-
-		GLint depthFunc;
-		glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
-
-		GLboolean depthMask;
-		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
-
-		GLboolean cullFace;
-		glGetBooleanv(GL_CULL_FACE, &cullFace);
+		// Save current GL state, answered by the state tracker without asking the driver
+		GLState& state = GLState::getInstance();
+		bool depthTest = state.isEnabled(GL_DEPTH_TEST);
+		GLenum depthFunc = state.getDepthFunc();
+		bool depthMask = state.getDepthMask();
+		bool cullFace = state.isEnabled(GL_CULL_FACE);
 
 		// We need to draw the skybox first, with depth write disabled to ensure it goes behind everything
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(GL_FALSE);	// Disable depth writes
-		glDepthFunc(GL_LEQUAL); // Use LEQUAL for depth test
+		state.setEnabled(GL_DEPTH_TEST, true);
+		state.depthMask(false);			// Disable depth writes
+		state.depthFunc(GL_LEQUAL); // Use LEQUAL for depth test
 
 		// Disable face culling to see all sides of the skybox
-		glDisable(GL_CULL_FACE);
+		state.setEnabled(GL_CULL_FACE, false);
 
 		// Use skybox shader
 		skyboxShader->bind();
@@ -162,63 +165,51 @@ void SkyboxVisualizer::draw(Scene const& scene)
 
 		// Remove translation from view matrix to keep skybox centered on camera
 		glm::mat4 skyboxView = glm::mat4(glm::mat3(scene.cam.view)); // Remove translation
-		skyboxShader->sendMat4("view", skyboxView);
-		skyboxShader->sendMat4("proj", scene.cam.proj);
-		skyboxShader->sendMat4("model", skyboxModelMat);
+		skyboxShader->set(modelViewLoc_, skyboxView);
+		skyboxShader->set(modelProjLoc_, scene.cam.proj);
+		skyboxShader->set(modelModelLoc_, skyboxModelMat);
 
 		// Draw the skybox model
 		this->skyboxModel->draw(*skyboxShader, skyboxModelMat);
 
 		// Restore previous GL state
-		if (cullFace)
-			glEnable(GL_CULL_FACE);
-
-		glDepthFunc(depthFunc); // Restore original depth function
-		glDepthMask(depthMask); // Restore original depth mask
-
-		if (!depthTest)
-			glDisable(GL_DEPTH_TEST);
+		state.setEnabled(GL_CULL_FACE, cullFace);
+		state.depthFunc(depthFunc); // Restore original depth function
+		state.depthMask(depthMask); // Restore original depth mask
+		state.setEnabled(GL_DEPTH_TEST, depthTest);
 	}
 	else if (skyboxType == SkyboxType::CUBEMAP && cubemapTexture && cubemapVAO) {
 		// Save current GL state
-		GLboolean depthTest;
-		glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-
-		GLint depthFunc;
-		glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
-
-		GLboolean depthMask;
-		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+		GLState& state = GLState::getInstance();
+		bool depthTest = state.isEnabled(GL_DEPTH_TEST);
+		GLenum depthFunc = state.getDepthFunc();
+		bool depthMask = state.getDepthMask();
 
 		// Set up GL state for skybox rendering
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(GL_FALSE);	// Disable depth writes
-		glDepthFunc(GL_LEQUAL); // Use LEQUAL for the depth test
+		state.setEnabled(GL_DEPTH_TEST, true);
+		state.depthMask(false);			// Disable depth writes
+		state.depthFunc(GL_LEQUAL); // Use LEQUAL for the depth test
 
 		// Use cubemap shader
 		cubemapShader->bind();
 
 		// Remove translation from view matrix to keep skybox centered on camera
 		glm::mat4 skyboxView = glm::mat4(glm::mat3(scene.cam.view)); // Remove translation
-		cubemapShader->sendMat4("view", skyboxView);
-		cubemapShader->sendMat4("proj", scene.cam.proj);
+		cubemapShader->set(cubemapViewLoc_, skyboxView);
+		cubemapShader->set(cubemapProjLoc_, scene.cam.proj);
 
 		// Bind the cubemap texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-		cubemapShader->sendInt("skybox", 0);
+		state.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+		cubemapShader->set(cubemapSamplerLoc_, 0);
 
 		// Render the cubemap
-		glBindVertexArray(cubemapVAO);
+		state.bindVertexArray(cubemapVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
 
 		// Restore previous GL state
-		glDepthFunc(depthFunc); // Restore original depth function
-		glDepthMask(depthMask); // Restore original depth mask
-
-		if (!depthTest)
-			glDisable(GL_DEPTH_TEST);
+		state.depthFunc(depthFunc); // Restore original depth function
+		state.depthMask(depthMask); // Restore original depth mask
+		state.setEnabled(GL_DEPTH_TEST, depthTest);
 	}
 }
 
@@ -0,0 +1,37 @@
+#include "StreamingBuffer.hpp"
+
+#include <iostream>
+
+void StreamingBuffer::init()
+{
+	// Binding once creates the object, so it can be attached (e.g. with glTexBuffer) before the first upload
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(target_, buffer_);
+	glBindBuffer(target_, 0);
+}
+
+void StreamingBuffer::cleanup()
+{
+	if (buffer_)
+		glDeleteBuffers(1, &buffer_);
+	buffer_ = 0;
+	capacity_ = 0;
+}
+
+void StreamingBuffer::upload(void const* data, std::size_t bytes)
+{
+	if (!buffer_ || bytes == 0)
+		return;
+
+	glBindBuffer(target_, buffer_);
+	if (bytes > capacity_) {
+		// Grow with headroom so a little more data next frame does not reallocate again
+		capacity_ = bytes + bytes / 2;
+		// std::cout << "[StreamingBuffer INFO] Growing to " << capacity_ << " bytes" << std::endl;
+	}
+
+	// Orphan last frame's storage so the driver does not wait for draws still reading it
+	glBufferData(target_, static_cast<GLsizeiptr>(capacity_), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(target_, 0, static_cast<GLsizeiptr>(bytes), data);
+	glBindBuffer(target_, 0);
+}
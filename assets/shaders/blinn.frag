@@ -2,17 +2,27 @@
 out vec4 FragColor;
 in VS_OUT{vec3 Pos;vec3 N;vec2 UV;} fs;
 uniform sampler2D tex0;   // base
+#ifdef OVERLAY_TEXTURE
 uniform sampler2D tex1;   // overlay, may be all‑transparent
-uniform vec3 lightPos, viewPos;
+#endif
+// Camera and lighting, one buffer for the whole frame (see FrameBlock)
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    vec4 lightPos;
+};
 
 void main()
 {
     // Sample textures
-    vec4 base = texture(tex0, fs.UV);
+    vec4 texColor = texture(tex0, fs.UV);
+#ifdef OVERLAY_TEXTURE
     vec4 eye = texture(tex1, fs.UV);
     
     // Choose overlay if it contributes color, otherwise use base
-    vec4 texColor = eye.a > 0.05 ? eye : base;
+    texColor = eye.a > 0.05 ? eye : texColor;
+#endif
     
     // If texture is completely transparent, discard the fragment
     if (texColor.a < 0.05) discard;
@@ -24,8 +34,13 @@ void main()
     
     // Prepare lighting variables
     vec3 N = normalize(fs.N);
-    vec3 L = normalize(lightPos - fs.Pos);
-    vec3 V = normalize(viewPos - fs.Pos);
+#ifdef DOUBLE_SIDED
+    // Back faces are lit from their own side
+    if (!gl_FrontFacing)
+        N = -N;
+#endif
+    vec3 L = normalize(lightPos.xyz - fs.Pos);
+    vec3 V = normalize(viewPos.xyz - fs.Pos);
     vec3 H = normalize(L + V);
     
     // Calculate lighting components
@@ -0,0 +1,108 @@
+#version 330 core
+
+// Permutations are compiled by ShaderVariants, which defines the feature keys below (see ShaderFeature)
+
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aNormal;      // Octahedral
+layout(location=2) in vec2 aUV;
+
+#ifdef SKINNING
+layout(location=3) in uvec4 aBoneIds;    // uint8 or uint16
+layout(location=4) in vec4 aBoneWeights; // unorm8
+#endif
+
+#ifdef INSTANCING
+layout(location=5) in mat4 aModel;        // Per instance, locations 5-8
+layout(location=9) in mat3 aNormalMatrix; // Per instance, locations 9-11
+layout(location=12) in int aPaletteOffset; // Per instance, first joint in the palette (see InstanceData)
+#endif
+
+// Camera and lighting, one buffer for the whole frame (see FrameBlock)
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+// This draw's record in the frame's draw buffer (see DrawBlock)
+layout(std140) uniform Draw {
+    mat4 model;
+    mat4 normalMatrix;
+    ivec4 skinning; // x: first joint in the palette
+};
+
+#ifdef SKINNING
+// Joint matrices of every skinned object this frame, four texels (columns) per matrix
+uniform samplerBuffer jointPalette;
+
+mat4 jointMatrix(int joint) {
+#ifdef INSTANCING
+    int texel = (aPaletteOffset + joint) * 4;
+#else
+    int texel = (skinning.x + joint) * 4;
+#endif
+    return mat4(texelFetch(jointPalette, texel),
+                texelFetch(jointPalette, texel + 1),
+                texelFetch(jointPalette, texel + 2),
+                texelFetch(jointPalette, texel + 3));
+}
+#endif
+
+out VS_OUT{
+    vec3 Pos;
+    vec3 N;
+    vec2 UV;
+} vs;
+
+// Normals arrive octahedral encoded (see Mesh::setup)
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    vec4 position = vec4(aPos, 1.0);
+    vec3 normal = octDecode(aNormal);
+
+#ifdef SKINNING
+    vec4 skinnedPos = vec4(0.0);
+    vec3 skinnedNormal = vec3(0.0);
+    float totalWeight = 0.0;
+
+    // Apply bone transformations
+    for(int i = 0; i < 4; i++) {
+        float weight = aBoneWeights[i];
+        if(weight > 0.0) {
+            totalWeight += weight;
+            mat4 bone = jointMatrix(int(aBoneIds[i]));
+            skinnedPos += weight * bone * position;
+            skinnedNormal += weight * mat3(bone) * normal; // Ignoring translation
+        }
+    }
+
+    // Meshes without weights (static parts of a skinned model) stay in the bind pose
+    if(totalWeight > 0.0) {
+        position = skinnedPos / totalWeight;
+        normal = normalize(skinnedNormal);
+    }
+#endif
+
+#ifdef INSTANCING
+    mat4 world = aModel;
+    mat3 normalWorld = aNormalMatrix;
+#else
+    mat4 world = model;
+    mat3 normalWorld = mat3(normalMatrix);
+#endif
+
+    // The normal matrix comes from the CPU, nothing is inverted per vertex
+    vec4 worldPos = world * position;
+    vs.Pos = worldPos.xyz;
+    vs.N = normalWorld * normal;
+    vs.UV = aUV;
+
+    gl_Position = proj * view * worldPos;
+}
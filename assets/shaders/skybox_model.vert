@@ -1,11 +1,19 @@
 #version 330 core
 layout(location=0) in vec3 aPos;
-layout(location=1) in vec3 aNormal;
+layout(location=1) in vec2 aNormal;
 layout(location=2) in vec2 aUV;
 
 uniform mat4 model, view, proj;
 out VS_OUT{vec3 Pos;vec3 N;vec2 UV;} vs;
 
+// Normals arrive octahedral encoded (see Mesh::setup)
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main() {
     // Transform position
     vec4 world = model * vec4(aPos, 1.0);
@@ -13,7 +21,7 @@ void main() {
     
     // Just pass the normal through without transforming it
     // This helps avoid any darkening from normal-based lighting calculations
-    vs.N = normalize(aNormal);
+    vs.N = octDecode(aNormal);
     
     // Pass UVs directly
     vs.UV = aUV;